@@ -0,0 +1,143 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Match3BenchmarkCommandlet.h"
+#include "Match3Benchmarks.h"
+#include "Dom/JsonObject.h"
+#include "Misc/FileHelper.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+
+static constexpr auto SamplesParam = TEXT("samples");
+static constexpr auto FilterParam = TEXT("filter");
+static constexpr auto BaselineParam = TEXT("baseline");
+static constexpr auto ToleranceParam = TEXT("tolerance");
+
+UMatch3BenchmarkCommandlet::UMatch3BenchmarkCommandlet()
+{
+    HelpDescription = TEXT("Runs the Match3 benchmark scenarios and writes their percentiles as json.");
+    HelpUsage = TEXT("<Editor-Cmd.exe> <path_to_uproject> -run=Match3Benchmark -output=<results.json> [-samples=2000] [-filter=<name>] [-baseline=<results.json>] [-tolerance=10] -nullrhi -unattended");
+
+    HelpParamNames.Add(SamplesParam);
+    HelpParamDescriptions.Add(TEXT("[Optional] Timed samples per scenario, 2000 by default."));
+
+    HelpParamNames.Add(FilterParam);
+    HelpParamDescriptions.Add(TEXT("[Optional] Only run scenarios whose name contains this."));
+
+    HelpParamNames.Add(BaselineParam);
+    HelpParamDescriptions.Add(TEXT("[Optional] Earlier output to compare against; any p50 regression past the tolerance fails the run."));
+
+    HelpParamNames.Add(ToleranceParam);
+    HelpParamDescriptions.Add(TEXT("[Optional] Allowed p50 slowdown against the baseline in percent, 10 by default."));
+}
+
+
+// scenario name -> p50 from an earlier run
+static bool LoadBaseline(const FString& Filename, TMap<FString, double>& OutP50)
+{
+    FString Text;
+    if (!FFileHelper::LoadFileToString(Text, *Filename)) return false;
+
+    TSharedPtr<FJsonObject> Root;
+    if (!FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(Text), Root) || !Root.IsValid()) return false;
+
+    const TArray<TSharedPtr<FJsonValue>>* Scenarios = nullptr;
+    if (!Root->TryGetArrayField(TEXT("scenarios"), Scenarios)) return false;
+
+    for (const TSharedPtr<FJsonValue>& Value : *Scenarios)
+    {
+        const TSharedPtr<FJsonObject>* Scenario = nullptr;
+        FString Name;
+        double P50 = 0.0;
+        if (Value->TryGetObject(Scenario) && (*Scenario)->TryGetStringField(TEXT("name"), Name)
+            && (*Scenario)->TryGetNumberField(TEXT("p50Ns"), P50))
+        {
+            OutP50.Add(Name, P50);
+        }
+    }
+    return true;
+}
+
+
+int32 UMatch3BenchmarkCommandlet::Run(
+    TArray<FString>& Tokens,
+    TArray<FString>& Switches,
+    TMap<FString, FString>& ParamVals,
+    FArchive& OutArchive)
+{
+    int32 NumSamples = 2000;
+    if (const FString* Samples = ParamVals.Find(SamplesParam))
+    {
+        NumSamples = FMath::Max(1, FCString::Atoi(**Samples));
+    }
+
+    TArray<Match3Bench::FScenarioResult> Results;
+    Match3Bench::RunScenarios(NumSamples, ParamVals.FindRef(FilterParam), Results);
+    if (Results.Num() == 0)
+    {
+        UE_LOG(LogTemp, Error, TEXT("Match3Benchmark: no scenario matched."));
+        return 1;
+    }
+
+    FString Json;
+    TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Json);
+    Writer->WriteObjectStart();
+    Writer->WriteValue(TEXT("version"), 1);
+    Writer->WriteArrayStart(TEXT("scenarios"));
+    for (const Match3Bench::FScenarioResult& Result : Results)
+    {
+        Writer->WriteObjectStart();
+        Writer->WriteValue(TEXT("name"), Result.Name);
+        Writer->WriteValue(TEXT("samples"), Result.Samples);
+        Writer->WriteValue(TEXT("opsPerSample"), Result.OpsPerSample);
+        Writer->WriteValue(TEXT("p50Ns"), Result.P50Ns);
+        Writer->WriteValue(TEXT("p90Ns"), Result.P90Ns);
+        Writer->WriteValue(TEXT("p99Ns"), Result.P99Ns);
+        Writer->WriteValue(TEXT("meanNs"), Result.MeanNs);
+        Writer->WriteValue(TEXT("opsPerSecond"), Result.OpsPerSecond);
+        Writer->WriteObjectEnd();
+
+        UE_LOG(LogTemp, Display, TEXT("%-26s p50 %10.1f ns  p90 %10.1f ns  p99 %10.1f ns  %12.0f ops/s"),
+            *Result.Name, Result.P50Ns, Result.P90Ns, Result.P99Ns, Result.OpsPerSecond);
+    }
+    Writer->WriteArrayEnd();
+    Writer->WriteObjectEnd();
+    Writer->Close();
+
+    FTCHARToUTF8 Utf8(*Json);
+    OutArchive.Serialize(const_cast<ANSICHAR*>(Utf8.Get()), Utf8.Length());
+
+    const FString BaselineFile = ParamVals.FindRef(BaselineParam);
+    if (BaselineFile.IsEmpty())
+    {
+        return 0;
+    }
+
+    TMap<FString, double> BaselineP50;
+    if (!LoadBaseline(BaselineFile, BaselineP50))
+    {
+        UE_LOG(LogTemp, Error, TEXT("Match3Benchmark: could not read baseline %s."), *BaselineFile);
+        return 1;
+    }
+
+    double TolerancePercent = 10.0;
+    if (const FString* Tolerance = ParamVals.Find(ToleranceParam))
+    {
+        TolerancePercent = FCString::Atod(**Tolerance);
+    }
+
+    // scenarios missing from the baseline are new, not regressions
+    int32 NumRegressed = 0;
+    for (const Match3Bench::FScenarioResult& Result : Results)
+    {
+        const double* Base = BaselineP50.Find(Result.Name);
+        if (Base && *Base > 0.0 && Result.P50Ns > *Base * (1.0 + TolerancePercent / 100.0))
+        {
+            UE_LOG(LogTemp, Error, TEXT("Match3Benchmark: %s regressed, p50 %.1f ns vs baseline %.1f ns (+%.1f%%)."),
+                *Result.Name, Result.P50Ns, *Base, (Result.P50Ns / *Base - 1.0) * 100.0);
+            ++NumRegressed;
+        }
+    }
+    return NumRegressed > 0 ? 1 : 0;
+}
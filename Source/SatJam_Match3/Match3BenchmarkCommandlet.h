@@ -0,0 +1,25 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Match3CommandletBase.h"
+#include "Match3BenchmarkCommandlet.generated.h"
+
+// runs the Match3Bench scenario set headless and writes p50/p90/p99 and throughput as json
+// with -baseline it fails (returns 1) when a scenario's p50 regressed past -tolerance
+UCLASS()
+class SATJAM_MATCH3_API UMatch3BenchmarkCommandlet : public UMatch3CommandletBase
+{
+    GENERATED_BODY()
+
+public:
+    UMatch3BenchmarkCommandlet();
+
+protected:
+    virtual int32 Run(
+        TArray<FString>& Tokens,
+        TArray<FString>& Switches,
+        TMap<FString, FString>& ParamVals,
+        FArchive& OutArchive) override;
+};
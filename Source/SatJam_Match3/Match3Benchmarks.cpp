@@ -0,0 +1,334 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Match3Benchmarks.h"
+#include "Match3Board.h"
+#include "Match3Solver.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+
+namespace
+{
+    // boards a few turns into a game, not fresh ones, so move counts look like play
+    void MakeBoards(int32 Rows, int32 Cols, int32 NumBoards, TArray<FMatch3Board>& OutBoards)
+    {
+        OutBoards.SetNum(NumBoards);
+        for (int32 i = 0; i < NumBoards; ++i)
+        {
+            FMatch3Board& Board = OutBoards[i];
+            Board.Init(Rows, Cols, i + 1);
+            Board.Regenerate();
+
+            for (int32 Turn = 0; Turn < 20; ++Turn)
+            {
+                const int32 CellA = Board.Stream.RandHelper(Board.Num());
+                const int32 CellB = Board.Stream.RandBool() ? CellA + 1 : CellA + Cols;
+                if (Board.AreAdjacent(CellA, CellB) && Board.TrySwap(CellA, CellB))
+                {
+                    Board.ResolveTurn();
+                }
+            }
+        }
+    }
+
+    double NsPerBoard(double Seconds, int32 NumBoards)
+    {
+        return NumBoards > 0 ? Seconds * 1e9 / NumBoards : 0.0;
+    }
+
+    // nearest rank on sorted samples
+    double Percentile(const TArray<double>& Sorted, double Percent)
+    {
+        if (Sorted.Num() == 0) return 0.0;
+        const int32 Rank = FMath::CeilToInt(Percent / 100.0 * Sorted.Num());
+        return Sorted[FMath::Clamp(Rank - 1, 0, Sorted.Num() - 1)];
+    }
+
+    // time NumSamples calls of Sample after a short warm up
+    template <typename SampleType>
+    void Measure(const FString& Name, int32 NumSamples, int32 OpsPerSample, const FString& Filter,
+        TArray<Match3Bench::FScenarioResult>& OutResults, SampleType&& Sample)
+    {
+        if (!Filter.IsEmpty() && !Name.Contains(Filter)) return;
+
+        for (int32 i = 0; i < NumSamples / 10 + 1; ++i)
+        {
+            Sample();
+        }
+
+        TArray<double> Times;
+        Times.SetNumUninitialized(NumSamples);
+        double Total = 0.0;
+        for (int32 i = 0; i < NumSamples; ++i)
+        {
+            const uint64 Start = FPlatformTime::Cycles64();
+            Sample();
+            const double Seconds = (FPlatformTime::Cycles64() - Start) * FPlatformTime::GetSecondsPerCycle64();
+            Times[i] = Seconds * 1e9 / OpsPerSample;
+            Total += Seconds;
+        }
+        Times.Sort();
+
+        Match3Bench::FScenarioResult& Result = OutResults.AddDefaulted_GetRef();
+        Result.Name = Name;
+        Result.Samples = NumSamples;
+        Result.OpsPerSample = OpsPerSample;
+        Result.P50Ns = Percentile(Times, 50.0);
+        Result.P90Ns = Percentile(Times, 90.0);
+        Result.P99Ns = Percentile(Times, 99.0);
+        Result.MeanNs = NumSamples > 0 ? Total * 1e9 / (static_cast<double>(NumSamples) * OpsPerSample) : 0.0;
+        Result.OpsPerSecond = Total > 0.0 ? static_cast<double>(NumSamples) * OpsPerSample / Total : 0.0;
+    }
+
+    // diagonal stripes of every color: no match and no move, random fills almost never are
+    bool MakeDeadBoard(int32 Rows, int32 Cols, TArray<uint8>& OutCells)
+    {
+        FMatch3Board Board;
+        Board.Init(Rows, Cols, 1);
+        for (int32 Row = 0; Row < Rows; ++Row)
+        {
+            for (int32 Col = 0; Col < Cols; ++Col)
+            {
+                Board.SetCell(Row, Col, static_cast<uint8>((Row + Col) % Board.NumColors));
+            }
+        }
+        OutCells = Board.Cells;
+        return !Board.HasAnyMatches() && !Board.HasPossibleMove();
+    }
+
+    // level-like shape for the masked scenarios: the corners cut out and a blocked
+    // pair across the middle, so two columns fall in two segments
+    TSharedRef<const FMatch3BoardShape> MakeLevelShape(int32 Rows, int32 Cols)
+    {
+        const FIntPoint Holes[] = { { 0, 0 }, { 0, Cols - 1 }, { Rows - 1, 0 }, { Rows - 1, Cols - 1 } };
+        const FIntPoint Blocked[] = { { Rows / 2, Cols / 2 - 1 }, { Rows / 2, Cols / 2 } };
+        return FMatch3BoardShape::Make(Rows, Cols, Holes, Blocked);
+    }
+
+    const TCHAR* MaskedSuffix(bool bMasked)
+    {
+        return bMasked ? TEXT("_masked") : TEXT("");
+    }
+}
+
+Match3Bench::FMoveEnumerationResult Match3Bench::CompareMoveEnumeration(int32 Rows, int32 Cols, int32 NumBoards)
+{
+    FMoveEnumerationResult Result;
+    Result.Boards = NumBoards;
+
+    TArray<FMatch3Board> Boards;
+    MakeBoards(Rows, Cols, NumBoards, Boards);
+
+    FMatch3MoveList Moves;
+    Moves.Reserve(Rows * Cols);
+
+    // one scan per board
+    int64 ScanMoves = 0;
+    double Start = FPlatformTime::Seconds();
+    for (const FMatch3Board& Board : Boards)
+    {
+        Board.FindAllMoves(Moves);
+        ScanMoves += Moves.Moves.Num();
+    }
+    Result.FindAllMovesNs = NsPerBoard(FPlatformTime::Seconds() - Start, NumBoards);
+
+    Start = FPlatformTime::Seconds();
+    for (FMatch3Board& Board : Boards)
+    {
+        Board.FindAllMovesWithClears(Moves);
+    }
+    Result.FindAllMovesWithClearsNs = NsPerBoard(FPlatformTime::Seconds() - Start, NumBoards);
+
+    // one check per candidate swap
+    int64 CandidateMoves = 0;
+    Start = FPlatformTime::Seconds();
+    for (FMatch3Board& Board : Boards)
+    {
+        for (int32 Cell = 0; Cell < Board.Num(); ++Cell)
+        {
+            for (const int32 Other : { Cell + 1, Cell + Cols })
+            {
+                if (Board.AreAdjacent(Cell, Other) && Board.TrySwap(Cell, Other))
+                {
+                    Board.SwapCells(Cell, Other);
+                    CandidateMoves++;
+                }
+            }
+        }
+    }
+    Result.PerCandidateNs = NsPerBoard(FPlatformTime::Seconds() - Start, NumBoards);
+
+    Result.Moves = ScanMoves;
+    Result.bMatched = ScanMoves == CandidateMoves;
+    return Result;
+}
+
+
+void Match3Bench::RunScenarios(int32 NumSamples, const FString& Filter, TArray<FScenarioResult>& OutResults)
+{
+    OutResults.Reset();
+    NumSamples = FMath::Max(1, NumSamples);
+
+    // separate from the boards, so each scenario sees the same swaps every run
+    FRandomStream Swaps(1234);
+
+    // generation; 9x9 and 12x12 have no bitboard kernel
+    const FIntPoint GenerateSizes[] = { { 6, 6 }, { 8, 8 }, { 10, 6 }, { 9, 9 }, { 12, 12 } };
+    for (const FIntPoint& Size : GenerateSizes)
+    {
+        FMatch3Board Board;
+        Board.Init(Size.X, Size.Y, 1);
+        Measure(FString::Printf(TEXT("generate_%dx%d"), Size.X, Size.Y), NumSamples, 1, Filter, OutResults,
+            [&Board]() { Board.Regenerate(); });
+    }
+
+    // the level sizes again with holes and blocked cells, next to their rectangles
+    const FIntPoint StormSizes[] = { { 10, 6 }, { 9, 9 } };
+    for (const FIntPoint& Size : StormSizes)
+    {
+        FMatch3Board Board;
+        Board.Init(Size.X, Size.Y, 1);
+        Board.SetShape(MakeLevelShape(Size.X, Size.Y));
+        Measure(FString::Printf(TEXT("generate_%dx%d_masked"), Size.X, Size.Y), NumSamples, 1, Filter, OutResults,
+            [&Board]() { Board.Regenerate(); });
+    }
+
+    // swap storms: random adjacent swaps, accepted ones resolve their whole turn
+    for (const bool bMasked : { false, true })
+    {
+        for (const FIntPoint& Size : StormSizes)
+        {
+            constexpr int32 SwapsPerSample = 64;
+            FMatch3Board Board;
+            Board.Init(Size.X, Size.Y, 1);
+            if (bMasked)
+            {
+                Board.SetShape(MakeLevelShape(Size.X, Size.Y));
+            }
+            Board.Regenerate();
+            Measure(FString::Printf(TEXT("swap_storm_%dx%d%s"), Size.X, Size.Y, MaskedSuffix(bMasked)), NumSamples, SwapsPerSample, Filter, OutResults,
+                [&Board, &Swaps]()
+                {
+                    for (int32 i = 0; i < SwapsPerSample; ++i)
+                    {
+                        const int32 CellA = Swaps.RandHelper(Board.Num());
+                        const int32 CellB = Swaps.RandBool() ? CellA + 1 : CellA + Board.Cols;
+                        if (Board.AreAdjacent(CellA, CellB) && Board.TrySwap(CellA, CellB))
+                        {
+                            Board.ResolveTurn();
+                        }
+                    }
+                });
+        }
+    }
+
+    // other color counts on the kernel size; 4 colors is swap_storm_10x6 above
+    for (const int32 NumColors : { 3, 6, 8 })
+    {
+        constexpr int32 SwapsPerSample = 64;
+        FMatch3Board Board;
+        Board.Init(10, 6, 1);
+        Board.SetNumColors(NumColors);
+        Measure(FString::Printf(TEXT("generate_10x6_%dcolors"), NumColors), NumSamples, 1, Filter, OutResults,
+            [&Board]() { Board.Regenerate(); });
+        Measure(FString::Printf(TEXT("swap_storm_10x6_%dcolors"), NumColors), NumSamples, SwapsPerSample, Filter, OutResults,
+            [&Board, &Swaps]()
+            {
+                for (int32 i = 0; i < SwapsPerSample; ++i)
+                {
+                    const int32 CellA = Swaps.RandHelper(Board.Num());
+                    const int32 CellB = Swaps.RandBool() ? CellA + 1 : CellA + Board.Cols;
+                    if (Board.AreAdjacent(CellA, CellB) && Board.TrySwap(CellA, CellB))
+                    {
+                        Board.ResolveTurn();
+                    }
+                }
+            });
+    }
+
+    // forced long cascades: every cell starts matched, the whole board clears and refills
+    for (const bool bMasked : { false, true })
+    {
+        FMatch3Board Board;
+        Board.Init(10, 6, 1);
+        if (bMasked)
+        {
+            Board.SetShape(MakeLevelShape(10, 6));
+        }
+        Board.MaxCascadeDepth = 1000;
+        Measure(FString::Printf(TEXT("cascade_full_clear_10x6%s"), MaskedSuffix(bMasked)), NumSamples, 1, Filter, OutResults,
+            [&Board]()
+            {
+                for (uint8& Color : Board.Cells)
+                {
+                    Color = 0;
+                }
+                Board.CellsChanged();
+                Board.ResolveTurn();
+            });
+    }
+
+    // dead-board recovery
+    TArray<uint8> DeadCells;
+    if (MakeDeadBoard(10, 6, DeadCells))
+    {
+        FMatch3Board Board;
+        Board.Init(10, 6, 1);
+        FMatch3CellList Source;
+        Source.Reserve(Board.Num());
+        Measure(TEXT("dead_shuffle_10x6"), NumSamples, 1, Filter, OutResults,
+            [&Board, &DeadCells, &Source]()
+            {
+                Board.Cells = DeadCells;
+                Board.CellsChanged();
+                Board.Shuffle(&Source);
+            });
+
+        int32 RegenSeed = 0;
+        Measure(TEXT("dead_regenerate_10x6"), NumSamples, 1, Filter, OutResults,
+            [&Board, &RegenSeed]() { Board.RegenerateFromSeed(++RegenSeed); });
+    }
+
+    // move enumeration on played boards
+    for (const FIntPoint& Size : StormSizes)
+    {
+        TArray<FMatch3Board> Boards;
+        MakeBoards(Size.X, Size.Y, 64, Boards);
+        FMatch3MoveList Moves;
+        Moves.Reserve(Size.X * Size.Y);
+        int32 Next = 0;
+        Measure(FString::Printf(TEXT("moves_%dx%d"), Size.X, Size.Y), NumSamples, 1, Filter, OutResults,
+            [&Boards, &Moves, &Next]() { Boards[Next++ % Boards.Num()].FindAllMoves(Moves); });
+    }
+
+    // best line in five moves on a level-sized board; seconds per solve, so a few samples
+    {
+        FMatch3Board Board;
+        Board.Init(10, 6, 9);
+        Board.Regenerate();
+        FMatch3PuzzleSettings Settings;
+        Settings.MaxMoves = 5;
+        Measure(TEXT("solve_10x6_depth5"), FMath::Min(NumSamples, 3), 1, Filter, OutResults,
+            [&Board, &Settings]() { FMatch3PuzzleSolver::Solve(Board, Settings); });
+    }
+}
+
+
+static void RunMoveBenchmark(const TArray<FString>& Args)
+{
+    const int32 NumBoards = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 10000;
+    const int32 Rows = Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 10;
+    const int32 Cols = Args.Num() > 2 ? FCString::Atoi(*Args[2]) : 6;
+
+    const Match3Bench::FMoveEnumerationResult Result = Match3Bench::CompareMoveEnumeration(Rows, Cols, NumBoards);
+    UE_LOG(LogTemp, Display, TEXT("Match3 moves %dx%d, %d boards, %.1f moves/board: FindAllMoves %.0f ns, with clears %.0f ns, per candidate %.0f ns (%.1fx)%s"),
+        Rows, Cols, NumBoards, NumBoards > 0 ? static_cast<double>(Result.Moves) / NumBoards : 0.0,
+        Result.FindAllMovesNs, Result.FindAllMovesWithClearsNs, Result.PerCandidateNs,
+        Result.FindAllMovesNs > 0.0 ? Result.PerCandidateNs / Result.FindAllMovesNs : 0.0,
+        Result.bMatched ? TEXT("") : TEXT(" MISMATCH"));
+}
+
+static FAutoConsoleCommand GMatch3BenchMovesCommand(
+    TEXT("Match3.BenchMoves"),
+    TEXT("Time full move enumeration against one TrySwap per candidate. Usage: Match3.BenchMoves [Boards] [Rows] [Cols]"),
+    FConsoleCommandWithArgsDelegate::CreateStatic(&RunMoveBenchmark));
@@ -0,0 +1,45 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// headless rule benchmarks on FMatch3Board, no world needed
+namespace Match3Bench
+{
+    struct FMoveEnumerationResult
+    {
+        int32 Boards = 0;
+        int64 Moves = 0;
+
+        // average per board
+        double FindAllMovesNs = 0.0;
+        double FindAllMovesWithClearsNs = 0.0;
+        double PerCandidateNs = 0.0;
+
+        // both ways found the same moves
+        bool bMatched = true;
+    };
+
+    // all legal swaps on NumBoards played-in boards: FindAllMoves in one scan
+    // against one TrySwap per candidate swap (what HasPossibleMove style callers do)
+    SATJAM_MATCH3_API FMoveEnumerationResult CompareMoveEnumeration(int32 Rows, int32 Cols, int32 NumBoards);
+
+    // timings of one scenario, per operation (a sample may run several)
+    struct FScenarioResult
+    {
+        FString Name;
+        int32 Samples = 0;
+        int32 OpsPerSample = 0;
+        double P50Ns = 0.0;
+        double P90Ns = 0.0;
+        double P99Ns = 0.0;
+        double MeanNs = 0.0;
+        double OpsPerSecond = 0.0;
+    };
+
+    // the fixed scenario set: board generation at several sizes, random swap storms,
+    // forced long cascades, dead-board recovery, move enumeration and a puzzle solve
+    // Filter keeps scenarios whose name contains it, empty runs all
+    SATJAM_MATCH3_API void RunScenarios(int32 NumSamples, const FString& Filter, TArray<FScenarioResult>& OutResults);
+}
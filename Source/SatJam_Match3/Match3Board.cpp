@@ -0,0 +1,798 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Match3Board.h"
+#include "Match3BoardKernels.h"
+
+void FMatch3Board::Init(int32 InRows, int32 InCols, int32 Seed)
+{
+    Rows = InRows;
+    Cols = InCols;
+    Score = 0;
+    Shape.Reset();
+    ResetCells();
+    Stream.Initialize(Seed);
+    SelectKernel();
+
+    TurnGroups.Reserve(Rows * Cols);
+    MatchMarks.Reserve(Rows * Cols);
+    ChangedCells.Reserve(Rows * Cols);
+    ShuffleColors.Reserve(Rows * Cols);
+    ShuffleCellsByColor.Reserve(Rows * Cols);
+    MoveCells.Reserve(2);
+    MoveMatches.Reserve(Rows * Cols);
+    ScanStamps.Init(0, Rows * Cols);
+    ScanGeneration = 0;
+}
+
+
+void FMatch3CascadeStats::Record(int32 Depth, bool bCapped)
+{
+    Turns++;
+    Steps += Depth;
+    MaxDepth = FMath::Max(MaxDepth, Depth);
+    DepthHistogram[FMath::Min(Depth, NumBuckets - 1)]++;
+    if (bCapped)
+    {
+        CappedTurns++;
+    }
+}
+
+
+void FMatch3Board::SelectKernel()
+{
+    Kernel = Match3Kernels::Find(Rows, Cols, NumColors);
+}
+
+
+void FMatch3Board::SetNumColors(int32 InNumColors)
+{
+    NumColors = FMath::Clamp(InNumColors, MinColors, MaxColors);
+    SelectKernel();
+}
+
+
+bool FMatch3Board::IsInside(int32 Row, int32 Col) const
+{
+    return Row >= 0 && Row < Rows && Col >= 0 && Col < Cols;
+}
+
+
+void FMatch3Board::SetShape(TSharedPtr<const FMatch3BoardShape> InShape)
+{
+    check(!InShape || (InShape->Rows == Rows && InShape->Cols == Cols));
+    Shape = MoveTemp(InShape);
+    ResetCells();
+}
+
+
+void FMatch3Board::ResetCells()
+{
+    Cells.Init(EmptyCell, Rows * Cols);
+    CellsChanged();
+}
+
+
+void FMatch3Board::CellsChanged()
+{
+    if (Shape && Shape->Kinds.Num() == Cells.Num())
+    {
+        for (int32 i = 0; i < Cells.Num(); ++i)
+        {
+            if (!Shape->IsCell(i))
+            {
+                Cells[i] = NoCell;
+            }
+        }
+    }
+
+    Hash = 0;
+    for (int32 i = 0; i < Cells.Num(); ++i)
+    {
+        Hash ^= ZobristKey(i, Cells[i]);
+    }
+
+    PadStride = Cols + 2;
+    Padded.Init(BorderCell, (Rows + 2) * PadStride);
+    for (int32 r = 0; r < Rows; ++r)
+    {
+        FMemory::Memcpy(&Padded[PaddedIndex(r, 0)], &Cells[Index(r, 0)], Cols);
+    }
+}
+
+
+void FMatch3Board::CopyCellsFrom(const FMatch3Board& Other)
+{
+    check(Other.Rows == Rows && Other.Cols == Cols);
+    FMemory::Memcpy(Cells.GetData(), Other.Cells.GetData(), Cells.Num());
+    FMemory::Memcpy(Padded.GetData(), Other.Padded.GetData(), Padded.Num());
+    Hash = Other.Hash;
+}
+
+
+void FMatch3Board::CopyFrom(const FMatch3Board& Other)
+{
+    // Init sizes the cells and reserves the scratch, a plain copy would leave the scratch empty
+    if (Other.Rows != Rows || Other.Cols != Cols)
+    {
+        Init(Other.Rows, Other.Cols, 0);
+    }
+
+    CopyCellsFrom(Other);
+    Score = Other.Score;
+    Scoring = Other.Scoring;
+    Stream = Other.Stream;
+    MaxCascadeDepth = Other.MaxCascadeDepth;
+    bShuffleDeadBoards = Other.bShuffleDeadBoards;
+    NumColors = Other.NumColors;
+    Kernel = Other.Kernel;
+    Shape = Other.Shape;
+}
+
+
+// make sure that there are no matches
+void FMatch3Board::FillRandomly()
+{
+    FillRandomly(Stream);
+}
+
+
+void FMatch3Board::FillRandomly(FRandomStream& InStream)
+{
+    ResetCells();
+
+    for (int32 r = 0; r < Rows; ++r)
+    {
+        for (int32 c = 0; c < Cols; ++c)
+        {
+            if (GetCell(r, c) == NoCell) continue;
+
+            uint8 Color;
+
+            while (true)
+            {
+                Color = RandomColor(InStream);
+
+                const bool bBadHorizontal = c >= 2 && GetCell(r, c - 1) == Color && GetCell(r, c - 2) == Color;
+                const bool bBadVertical = r >= 2 && GetCell(r - 1, c) == Color && GetCell(r - 2, c) == Color;
+
+                if (!bBadHorizontal && !bBadVertical)
+                    break;
+            }
+
+            SetCell(r, c, Color);
+        }
+    }
+}
+
+
+void FMatch3Board::Regenerate()
+{
+    RegenerateWith(Stream);
+}
+
+
+bool FMatch3Board::Shuffle(FMatch3CellList* OutSource)
+{
+    const int32 NumCells = Num();
+    ShuffleColors = Cells;
+
+    // old cells grouped by color, ColorStart[c] is where color c begins; holes stay put
+    int32 ColorCounts[MaxColors] = {};
+    for (uint8 Color : ShuffleColors)
+    {
+        if (Color == NoCell) continue;
+        if (Color >= NumColors) return false;
+        ColorCounts[Color]++;
+    }
+
+    int32 ColorStart[MaxColors + 1] = {};
+    for (int32 c = 0; c < NumColors; ++c)
+    {
+        ColorStart[c + 1] = ColorStart[c] + ColorCounts[c];
+    }
+
+    ShuffleCellsByColor.SetNumUninitialized(NumCells, EAllowShrinking::No);
+    {
+        int32 Fill[MaxColors];
+        FMemory::Memcpy(Fill, ColorStart, sizeof(Fill));
+        for (int32 i = 0; i < NumCells; ++i)
+        {
+            if (ShuffleColors[i] != NoCell)
+            {
+                ShuffleCellsByColor[Fill[ShuffleColors[i]]++] = i;
+            }
+        }
+    }
+
+    for (int32 Attempt = 0; Attempt < MaxShuffleAttempts; ++Attempt)
+    {
+        // place cell by cell, picking among the colors left that do not finish a
+        // line to the left or above, weighted by how many are left
+        int32 Left[MaxColors];
+        FMemory::Memcpy(Left, ColorCounts, sizeof(Left));
+
+        bool bPlaced = true;
+        for (int32 r = 0; r < Rows && bPlaced; ++r)
+        {
+            for (int32 c = 0; c < Cols; ++c)
+            {
+                if (GetCell(r, c) == NoCell) continue;
+
+                int32 Total = 0;
+                int32 Weights[MaxColors];
+                for (int32 Color = 0; Color < NumColors; ++Color)
+                {
+                    const bool bBadHorizontal = c >= 2 && GetCell(r, c - 1) == Color && GetCell(r, c - 2) == Color;
+                    const bool bBadVertical = r >= 2 && GetCell(r - 1, c) == Color && GetCell(r - 2, c) == Color;
+                    Weights[Color] = (bBadHorizontal || bBadVertical) ? 0 : Left[Color];
+                    Total += Weights[Color];
+                }
+
+                if (Total == 0)
+                {
+                    bPlaced = false;
+                    break;
+                }
+
+                int32 Pick = Stream.RandRange(0, Total - 1);
+                uint8 Color = 0;
+                while (Pick >= Weights[Color])
+                {
+                    Pick -= Weights[Color];
+                    Color++;
+                }
+
+                SetCell(r, c, Color);
+                Left[Color]--;
+            }
+        }
+
+        if (!bPlaced || !HasPossibleMove()) continue;
+
+        // hand out the old cells of each color in order
+        if (OutSource)
+        {
+            OutSource->SetNumUninitialized(NumCells, EAllowShrinking::No);
+            int32 Next[MaxColors];
+            FMemory::Memcpy(Next, ColorStart, sizeof(Next));
+            for (int32 i = 0; i < NumCells; ++i)
+            {
+                (*OutSource)[i] = Cells[i] == NoCell ? i : ShuffleCellsByColor[Next[Cells[i]]++];
+            }
+        }
+        return true;
+    }
+
+    Cells = ShuffleColors;
+    CellsChanged();
+    return false;
+}
+
+
+void FMatch3Board::RegenerateFromSeed(int32 RegenSeed)
+{
+    FRandomStream RegenStream(RegenSeed);
+    RegenerateWith(RegenStream);
+}
+
+
+void FMatch3Board::RegenerateWith(FRandomStream& InStream)
+{
+    // try generating until the rules are satisfied
+    // - no initial 3+ matches
+    // - at least one possible move
+    int32 Attempt = 0;
+
+    do
+    {
+        FillRandomly(InStream);
+        Attempt++;
+        if (Attempt >= MaxRegenerateAttempts)
+        {
+            UE_LOG(LogTemp, Warning, TEXT("Regenerate: Max attempts reached; accepting current board."));
+            break;
+        }
+    } while (HasAnyMatches() || !HasPossibleMove());
+}
+
+
+void FMatch3Board::FindAllMatches(FMatch3CellList& OutCells) const
+{
+    if (Kernel)
+    {
+        Kernel->FindAllMatches(Cells.GetData(), OutCells);
+        return;
+    }
+
+    OutCells.Reset();
+
+    // a cell can be part of a horizontal and a vertical run, mark to keep indices unique
+    TArray<uint8, FMatch3ScratchAllocator>& Marked = MatchMarks;
+    Marked.SetNumZeroed(Cells.Num(), EAllowShrinking::No);
+
+    // runs end at the frame, so only the colors are compared
+    // Horizontal
+    for (int32 r = 0; r < Rows; ++r)
+    {
+        const uint8* Row = &Padded[PaddedIndex(r, 0)];
+        int32 c = 0;
+        while (c < Cols)
+        {
+            const uint8 Color = Row[c];
+            const int32 RunEnd = c + 1 + CountRun(Row + c, 1, Color);
+            if (Color < NumColors && RunEnd - c >= 3)
+            {
+                for (int32 k = c; k < RunEnd; ++k)
+                {
+                    Marked[Index(r, k)] = 1;
+                }
+            }
+            c = RunEnd;
+        }
+    }
+
+    // Vertical
+    for (int32 c = 0; c < Cols; ++c)
+    {
+        const uint8* Column = &Padded[PaddedIndex(0, c)];
+        int32 r = 0;
+        while (r < Rows)
+        {
+            const uint8 Color = Column[r * PadStride];
+            const int32 RunEnd = r + 1 + CountRun(Column + r * PadStride, PadStride, Color);
+            if (Color < NumColors && RunEnd - r >= 3)
+            {
+                for (int32 k = r; k < RunEnd; ++k)
+                {
+                    Marked[Index(k, c)] = 1;
+                }
+            }
+            r = RunEnd;
+        }
+    }
+
+    for (int32 i = 0; i < Marked.Num(); ++i)
+    {
+        if (Marked[i])
+        {
+            OutCells.Add(i);
+        }
+    }
+}
+
+
+bool FMatch3Board::HasAnyMatches() const
+{
+    if (Kernel) return Kernel->HasAnyMatches(Cells.GetData());
+
+    for (int32 r = 0; r < Rows; ++r)
+    {
+        for (int32 c = 0; c < Cols; ++c)
+        {
+            if (HasMatchAt(r, c)) return true;
+        }
+    }
+    return false;
+}
+
+
+int32 FMatch3Board::RunLength(int32 Row, int32 Col, int32 DRow, int32 DCol) const
+{
+    const uint8* Cell = &Padded[PaddedIndex(Row, Col)];
+    return CountRun(Cell, DRow * PadStride + DCol, *Cell);
+}
+
+
+bool FMatch3Board::HasMatchAt(int32 Row, int32 Col) const
+{
+    if (GetCell(Row, Col) >= NumColors) return false;
+    if (RunLength(Row, Col, 0, -1) + 1 + RunLength(Row, Col, 0, 1) >= 3) return true;
+    if (RunLength(Row, Col, -1, 0) + 1 + RunLength(Row, Col, 1, 0) >= 3) return true;
+    return false;
+}
+
+
+bool FMatch3Board::HasPossibleMove() const
+{
+    if (Kernel) return Kernel->HasPossibleMove(Cells.GetData());
+
+    for (int32 r = 0; r < Rows; ++r)
+    {
+        for (int32 c = 0; c < Cols; ++c)
+        {
+            // right
+            if (c + 1 < Cols && SwapCreatesMatch(r, c, r, c + 1)) return true;
+            // down
+            if (r + 1 < Rows && SwapCreatesMatch(r, c, r + 1, c)) return true;
+        }
+    }
+
+    return false;
+}
+
+
+// swap colors only, a new match has to run through one of the swapped cells
+// (r2, c2) is right of or below (r1, c1)
+bool FMatch3Board::SwapCreatesMatch(int32 r1, int32 c1, int32 r2, int32 c2) const
+{
+    const uint8* Cell1 = &Padded[PaddedIndex(r1, c1)];
+    const uint8* Cell2 = &Padded[PaddedIndex(r2, c2)];
+    const uint8 Col1 = *Cell1;
+    const uint8 Col2 = *Cell2;
+    if (Col1 == Col2 || Col1 >= NumColors || Col2 >= NumColors) return false;
+
+    // after the swap a line from one cell stops at the other (its color differs),
+    // so every count reads the board as it is, away from the other cell only
+    const int32 Along = static_cast<int32>(Cell2 - Cell1);
+    const int32 Across = Along == 1 ? PadStride : 1;
+
+    return CountRun(Cell1, -Along, Col2) >= 2
+        || CountRun(Cell1, -Across, Col2) + CountRun(Cell1, Across, Col2) >= 2
+        || CountRun(Cell2, Along, Col1) >= 2
+        || CountRun(Cell2, -Across, Col1) + CountRun(Cell2, Across, Col1) >= 2;
+}
+
+
+void FMatch3MoveList::Reserve(int32 NumCells)
+{
+    // at most one right and one down swap per cell
+    Moves.Reserve(NumCells * 2);
+    ClearedCells.Reserve(NumCells * 2 * 5);
+}
+
+
+void FMatch3MoveList::Reset()
+{
+    Moves.Reset();
+    ClearedCells.Reset();
+}
+
+
+void FMatch3Board::FindAllMoves(FMatch3MoveList& OutMoves) const
+{
+    OutMoves.Reset();
+
+    if (Kernel)
+    {
+        // one mask per direction, bit = CellA
+        uint64 Right = 0;
+        uint64 Down = 0;
+        Kernel->FindAllMoves(Cells.GetData(), Right, Down);
+
+        for (uint64 Mask = Right; Mask; Mask &= Mask - 1)
+        {
+            const int32 Cell = static_cast<int32>(FMath::CountTrailingZeros64(Mask));
+            OutMoves.Moves.Add({ Cell, Cell + 1, 0, 0 });
+        }
+        for (uint64 Mask = Down; Mask; Mask &= Mask - 1)
+        {
+            const int32 Cell = static_cast<int32>(FMath::CountTrailingZeros64(Mask));
+            OutMoves.Moves.Add({ Cell, Cell + Cols, 0, 0 });
+        }
+        return;
+    }
+
+    for (int32 r = 0; r < Rows; ++r)
+    {
+        for (int32 c = 0; c + 1 < Cols; ++c)
+        {
+            if (SwapCreatesMatch(r, c, r, c + 1))
+            {
+                OutMoves.Moves.Add({ Index(r, c), Index(r, c + 1), 0, 0 });
+            }
+        }
+    }
+    for (int32 r = 0; r + 1 < Rows; ++r)
+    {
+        for (int32 c = 0; c < Cols; ++c)
+        {
+            if (SwapCreatesMatch(r, c, r + 1, c))
+            {
+                OutMoves.Moves.Add({ Index(r, c), Index(r + 1, c), 0, 0 });
+            }
+        }
+    }
+}
+
+
+void FMatch3Board::FindAllMovesWithClears(FMatch3MoveList& OutMoves)
+{
+    FindAllMoves(OutMoves);
+
+    MoveCells.SetNumUninitialized(2, EAllowShrinking::No);
+    for (FMatch3Move& Move : OutMoves.Moves)
+    {
+        // the board was settled, so the swap's matches run through its two cells
+        MoveCells[0] = Move.CellA;
+        MoveCells[1] = Move.CellB;
+        SwapCells(Move.CellA, Move.CellB);
+        FindMatchesFrom(MoveCells, MoveMatches);
+        SwapCells(Move.CellA, Move.CellB);
+
+        Move.FirstCleared = OutMoves.ClearedCells.Num();
+        Move.NumCleared = MoveMatches.Num();
+        OutMoves.ClearedCells.Append(MoveMatches);
+    }
+}
+
+
+bool FMatch3Board::AreAdjacent(int32 CellA, int32 CellB) const
+{
+    if (!Cells.IsValidIndex(CellA) || !Cells.IsValidIndex(CellB)) return false;
+    const int32 dR = FMath::Abs(CellA / Cols - CellB / Cols);
+    const int32 dC = FMath::Abs(CellA % Cols - CellB % Cols);
+    return (dR + dC) == 1;
+}
+
+
+void FMatch3Board::SwapCells(int32 CellA, int32 CellB)
+{
+    const uint8 ColorA = Cells[CellA];
+    SetCell(CellA, Cells[CellB]);
+    SetCell(CellB, ColorA);
+}
+
+
+bool FMatch3Board::TrySwap(int32 CellA, int32 CellB)
+{
+    if (!AreAdjacent(CellA, CellB)) return false;
+
+    // holes and blocked cells never move
+    if (Cells[CellA] == NoCell || Cells[CellB] == NoCell) return false;
+
+    SwapCells(CellA, CellB);
+
+    // the board was settled before the swap, so any match runs through A or B
+    if (HasMatchAt(CellA / Cols, CellA % Cols) || HasMatchAt(CellB / Cols, CellB % Cols))
+    {
+        return true;
+    }
+
+    // swap back
+    SwapCells(CellA, CellB);
+    return false;
+}
+
+
+void FMatch3Board::FindMatchesFrom(const FMatch3CellList& InCells, FMatch3CellList& OutCells) const
+{
+    OutCells.Reset();
+
+    enum : uint32 { ScannedH = 1, ScannedV = 2, Matched = 4 };
+
+    if (ScanStamps.Num() != Cells.Num())
+    {
+        ScanStamps.Init(0, Cells.Num());
+    }
+    if (++ScanGeneration >= (1u << 29))
+    {
+        // wrapped, old stamps could look current
+        FMemory::Memzero(ScanStamps.GetData(), ScanStamps.Num() * sizeof(uint32));
+        ScanGeneration = 1;
+    }
+    const uint32 Gen = ScanGeneration << 3;
+
+    auto GetFlags = [&](int32 Cell) -> uint32
+        {
+            const uint32 Stamp = ScanStamps[Cell];
+            return (Stamp & ~7u) == Gen ? (Stamp & 7u) : 0;
+        };
+    auto AddFlags = [&](int32 Cell, uint32 Flags)
+        {
+            ScanStamps[Cell] = Gen | GetFlags(Cell) | Flags;
+        };
+
+    // walk the run through Cell once per direction, every cell on it is then scanned
+    // the run is measured on the padded copy (PadStep) and marked on Cells (Step)
+    auto ScanRun = [&](int32 Cell, const uint8* PaddedCell, int32 Step, int32 PadStep, uint32 Flag)
+        {
+            const uint8 Color = *PaddedCell;
+            const int32 First = Cell - CountRun(PaddedCell, -PadStep, Color) * Step;
+            const int32 Last = Cell + CountRun(PaddedCell, PadStep, Color) * Step;
+
+            const bool bMatch = Color < NumColors && (Last - First) / Step + 1 >= 3;
+            for (int32 i = First; i <= Last; i += Step)
+            {
+                AddFlags(i, Flag);
+                if (bMatch && !(GetFlags(i) & Matched))
+                {
+                    AddFlags(i, Matched);
+                    OutCells.Add(i);
+                }
+            }
+        };
+
+    for (int32 Cell : InCells)
+    {
+        const uint8* PaddedCell = &Padded[PaddedIndex(Cell / Cols, Cell % Cols)];
+        const uint32 Flags = GetFlags(Cell);
+
+        if (!(Flags & ScannedH)) ScanRun(Cell, PaddedCell, 1, 1, ScannedH);
+        if (!(Flags & ScannedV)) ScanRun(Cell, PaddedCell, Cols, PadStride, ScannedV);
+    }
+}
+
+
+void FMatch3Board::ClearCells(const FMatch3CellList& InCells)
+{
+    for (int32 Cell : InCells)
+    {
+        SetCell(Cell, EmptyCell);
+    }
+}
+
+
+void FMatch3Board::ApplyGravityAndRefill(FMatch3CellList* OutChangedCells)
+{
+    if (OutChangedCells)
+    {
+        OutChangedCells->Reset();
+    }
+
+    if (Shape)
+    {
+        ApplyShapedGravityAndRefill(OutChangedCells);
+        return;
+    }
+
+    // shift cells down column by column
+    for (int32 c = 0; c < Cols; ++c)
+    {
+        int32 WriteRow = Rows - 1;
+        int32 LowestEmpty = INDEX_NONE;
+        for (int32 r = Rows - 1; r >= 0; --r)
+        {
+            const uint8 Color = GetCell(r, c);
+            if (Color == EmptyCell)
+            {
+                if (LowestEmpty == INDEX_NONE) LowestEmpty = r;
+            }
+            else
+            {
+                if (WriteRow != r)
+                {
+                    SetCell(WriteRow, c, Color);
+                    SetCell(r, c, EmptyCell);
+                }
+                WriteRow--;
+            }
+        }
+
+        // fill remaining above
+        for (int32 r = WriteRow; r >= 0; --r)
+        {
+            SetCell(r, c, RandomColor(Stream));
+        }
+
+        // everything at or above the lowest hole moved or is new
+        if (OutChangedCells)
+        {
+            for (int32 r = 0; r <= LowestEmpty; ++r)
+            {
+                OutChangedCells->Add(Index(r, c));
+            }
+        }
+    }
+}
+
+
+// same compaction per fall segment, in the same order as the columns above (a
+// shape without holes refills exactly like the rectangle)
+void FMatch3Board::ApplyShapedGravityAndRefill(FMatch3CellList* OutChangedCells)
+{
+    for (const FMatch3BoardShape::FSegment& Segment : Shape->Segments)
+    {
+        const int32* SegmentRows = Shape->FallRows.GetData() + Segment.First;
+        const int32 c = Segment.Col;
+        int32 Write = 0;
+        int32 LowestEmpty = INDEX_NONE;
+        for (int32 i = 0; i < Segment.Num; ++i)
+        {
+            const uint8 Color = GetCell(SegmentRows[i], c);
+            if (Color == EmptyCell)
+            {
+                if (LowestEmpty == INDEX_NONE) LowestEmpty = i;
+            }
+            else
+            {
+                if (Write != i)
+                {
+                    SetCell(SegmentRows[Write], c, Color);
+                    SetCell(SegmentRows[i], c, EmptyCell);
+                }
+                Write++;
+            }
+        }
+
+        // fill the rest of the segment from its top
+        for (int32 i = Write; i < Segment.Num; ++i)
+        {
+            SetCell(SegmentRows[i], c, RandomColor(Stream));
+        }
+
+        if (OutChangedCells && LowestEmpty != INDEX_NONE)
+        {
+            for (int32 i = Segment.Num - 1; i >= LowestEmpty; --i)
+            {
+                OutChangedCells->Add(Index(SegmentRows[i], c));
+            }
+        }
+    }
+}
+
+
+void FMatch3Board::ApplyClear(const FMatch3GroupBuffer& Groups, int32 CascadeDepth)
+{
+    Scoring.AddClear(Groups, CascadeDepth);
+    ClearCells(Groups.MatchedCells);
+}
+
+
+void FMatch3Board::BeginCascade(FMatch3GroupBuffer& Groups)
+{
+    Scoring.BeginTurn();
+    Groups.Build(*this);
+}
+
+
+bool FMatch3Board::StepCascade(FMatch3GroupBuffer& Groups, int32& Depth)
+{
+    if (Groups.MatchedCells.Num() == 0) return false;
+
+    ApplyClear(Groups, ++Depth);
+    ApplyGravityAndRefill(&ChangedCells);
+
+    // the bitboard kernels rescan everything faster than walking a worklist
+    if (Kernel)
+    {
+        Groups.Build(*this);
+    }
+    else
+    {
+        FindMatchesFrom(ChangedCells, Groups.MatchedCells);
+        Groups.BuildFromMatches(*this);
+    }
+
+    return Groups.MatchedCells.Num() > 0 && Depth < MaxCascadeDepth;
+}
+
+
+bool FMatch3Board::EndCascade(const FMatch3GroupBuffer& Groups, int32 Depth)
+{
+    const bool bCapped = Groups.MatchedCells.Num() > 0;
+    if (bCapped)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("Cascade depth cap (%d) reached; regenerating."), MaxCascadeDepth);
+    }
+
+    Scoring.CommitTurn(Score);
+    CascadeStats.Record(Depth, bCapped);
+
+    // no moves? regenerate, the score carries over
+    return bCapped || !HasPossibleMove();
+}
+
+
+bool FMatch3Board::ResolveCascade(int32& OutDepth)
+{
+    OutDepth = 0;
+    BeginCascade(TurnGroups);
+    while (StepCascade(TurnGroups, OutDepth))
+    {
+    }
+
+    return EndCascade(TurnGroups, OutDepth);
+}
+
+
+int32 FMatch3Board::ResolveTurn()
+{
+    int32 Depth = 0;
+    if (ResolveCascade(Depth) && !TryShuffleDeadBoard())
+    {
+        Regenerate();
+    }
+
+    return Depth;
+}
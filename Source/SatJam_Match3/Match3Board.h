@@ -0,0 +1,299 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Math/RandomStream.h"
+#include "Match3Groups.h"
+#include "Match3Score.h"
+#include "Match3BoardShape.h"
+
+struct FMatch3BoardKernel;
+
+// cascade depth statistics over resolved turns
+struct SATJAM_MATCH3_API FMatch3CascadeStats
+{
+    // last bucket collects everything deeper
+    static constexpr int32 NumBuckets = 16;
+
+    int32 Turns = 0;
+    int64 Steps = 0;
+    int32 MaxDepth = 0;
+    int32 CappedTurns = 0;
+    int32 DepthHistogram[NumBuckets] = {};
+
+    void Record(int32 Depth, bool bCapped);
+    float GetAverageDepth() const { return Turns > 0 ? static_cast<float>(Steps) / Turns : 0.f; }
+};
+
+// a legal swap, CellA < CellB; the cells its first clear takes are
+// ClearedCells[FirstCleared .. FirstCleared + NumCleared) of the list
+struct FMatch3Move
+{
+    int32 CellA = 0;
+    int32 CellB = 0;
+    int32 FirstCleared = 0;
+    int32 NumCleared = 0;
+};
+
+// reusable output of FMatch3Board::FindAllMoves
+// horizontal swaps first, then vertical, each by CellA
+struct FMatch3MoveList
+{
+    TArray<FMatch3Move, FMatch3ScratchAllocator> Moves;
+    FMatch3CellList ClearedCells;
+
+    void Reserve(int32 NumCells);
+    void Reset();
+};
+
+// data-only board: colors and rng, no actors or timers
+// AMatch3Grid runs its rules on this and keeps tile actors in sync with it,
+// so the same rules can be replayed headless
+struct SATJAM_MATCH3_API FMatch3Board
+{
+    // cell value for a cleared cell waiting for refill
+    static constexpr uint8 EmptyCell = 0xFF;
+
+    // border value of the padded copy, equal to no color and not empty
+    static constexpr uint8 BorderCell = 0xFE;
+
+    // cell value for a hole or blocked cell of a shaped board, never matches or moves
+    static constexpr uint8 NoCell = 0xFD;
+
+    // tile colors a board can be set to (ETileColor has MaxColors values)
+    static constexpr int32 MinColors = 3;
+    static constexpr int32 MaxColors = 8;
+    static constexpr int32 DefaultNumColors = 4;
+
+    // board sizes the rules support, replays and snapshots outside these are rejected
+    static constexpr int32 MinSize = 3;
+    static constexpr int32 MaxSize = 32;
+
+    // safety limit for Regenerate
+    static constexpr int32 MaxRegenerateAttempts = 50;
+
+    // tries for Shuffle before it gives up
+    static constexpr int32 MaxShuffleAttempts = 20;
+
+    // cascade steps per turn before the board gives up and regenerates
+    int32 MaxCascadeDepth = 100;
+
+    // dead boards rearrange their colors (Shuffle) before falling back to Regenerate
+    bool bShuffleDeadBoards = false;
+
+    // colors 0 .. NumColors - 1 are tiles, set through SetNumColors; kept by Init
+    int32 NumColors = DefaultNumColors;
+
+    int32 Rows = 0;
+    int32 Cols = 0;
+    int32 Score = 0;
+
+    // turns add to Score through this, whichever path resolves them
+    FMatch3ScoreAccumulator Scoring;
+
+    // flattened colors, Row * Cols + Col
+    // write through SetCell/SwapCells/ClearCells so Hash and the padded copy stay
+    // current, or call CellsChanged after writing the array directly
+    TArray<uint8> Cells;
+
+    // Zobrist hash of Cells: XOR of ZobristKey(cell, color) over the colored cells,
+    // so each write updates it in O(1); equal boards of the same size hash equal
+    uint64 Hash = 0;
+
+    // every random color comes from here so a seed reproduces a session
+    FRandomStream Stream;
+
+    // specialized scans for this size (see Match3BoardKernels.h), null for the generic loops
+    const FMatch3BoardKernel* Kernel = nullptr;
+
+    // holes and blocked cells of the level, null for a full rectangle
+    TSharedPtr<const FMatch3BoardShape> Shape;
+
+    // scratch for ResolveTurn, reserved from Rows * Cols in Init
+    FMatch3GroupBuffer TurnGroups;
+
+    FMatch3CascadeStats CascadeStats;
+
+    // size the board, seed the stream and reserve scratch, cells are left empty
+    // and the board is a full rectangle again (see SetShape)
+    void Init(int32 InRows, int32 InCols, int32 Seed);
+
+    // pick the kernel for Rows/Cols, call after changing the size without Init
+    void SelectKernel();
+
+    // clamped to [MinColors, MaxColors], picks the kernel for the new count; cells are
+    // left as they are, regenerate before playing
+    void SetNumColors(int32 InNumColors);
+
+    // use a level shape of the same size (null for a rectangle), after Init; cells are
+    // left empty with NoCell in the holes
+    void SetShape(TSharedPtr<const FMatch3BoardShape> InShape);
+
+    static inline bool IsSupportedSize(int32 InRows, int32 InCols)
+    {
+        return InRows >= MinSize && InRows <= MaxSize && InCols >= MinSize && InCols <= MaxSize;
+    }
+
+    inline int32 Index(int32 Row, int32 Col) const { return Row * Cols + Col; }
+    inline int32 Num() const { return Cells.Num(); }
+    bool IsInside(int32 Row, int32 Col) const;
+
+    inline uint8 GetCell(int32 Row, int32 Col) const { return Cells[Index(Row, Col)]; }
+    inline void SetCell(int32 Row, int32 Col, uint8 Color) { WriteCell(Index(Row, Col), PaddedIndex(Row, Col), Color); }
+    inline void SetCell(int32 Cell, uint8 Color) { WriteCell(Cell, PaddedIndex(Cell / Cols, Cell % Cols), Color); }
+
+    // per cell and color random key, empty cells and holes add nothing
+    // a fixed mix of the pair rather than a table, so any size and color count works
+    static inline uint64 ZobristKey(int32 Cell, uint8 Color)
+    {
+        if (Color == EmptyCell || Color == NoCell) return 0;
+        uint64 Key = (static_cast<uint64>(Cell) << 8 | Color) + 0x9E3779B97F4A7C15ull;
+        Key = (Key ^ (Key >> 30)) * 0xBF58476D1CE4E5B9ull;
+        Key = (Key ^ (Key >> 27)) * 0x94D049BB133111EBull;
+        return Key ^ (Key >> 31);
+    }
+
+    // rebuild Hash and the padded copy after Cells (or the size) was written directly,
+    // NoCell is put back into the shape's holes
+    void CellsChanged();
+
+    // colors and hash of a board of the same size, without reallocating
+    void CopyCellsFrom(const FMatch3Board& Other);
+
+    // the whole game state (cells, score, stream, rules, shape); reuses this board's
+    // buffers when the size matches, otherwise sizes them once like Init
+    void CopyFrom(const FMatch3Board& Other);
+
+    // fill with random colors avoiding initial 3+ matches
+    void FillRandomly();
+    void FillRandomly(FRandomStream& InStream);
+
+    // fill until there are no matches and at least one possible move
+    void Regenerate();
+
+    // rearrange the current colors, keeping how many there are of each, so there
+    // are no matches and at least one move; OutSource[i] is the old cell of the
+    // color now at i; false leaves the board as it was
+    bool Shuffle(FMatch3CellList* OutSource = nullptr);
+
+    // after a turn that ended on a dead board: shuffle if enabled, false if it
+    // still has to be regenerated
+    bool TryShuffleDeadBoard() { return bShuffleDeadBoards && Shuffle(); }
+
+    // same from a stream of its own, leaves Stream alone so a board can be made
+    // ahead of time (see FMatch3BoardPool) and a replay only needs the seed
+    void RegenerateFromSeed(int32 RegenSeed);
+
+    // all matched cells (3+ horizontal or vertical), unique indices
+    void FindAllMatches(FMatch3CellList& OutCells) const;
+    bool HasAnyMatches() const;
+
+    // detect if any single adjacent swap would create a match
+    bool HasPossibleMove() const;
+
+    // every legal swap in one scan, no cleared cells
+    void FindAllMoves(FMatch3MoveList& OutMoves) const;
+
+    // every legal swap and the cells its first clear takes (cascades depend on
+    // refills); swaps each move in place and back, the board ends unchanged
+    void FindAllMovesWithClears(FMatch3MoveList& OutMoves);
+
+    bool AreAdjacent(int32 CellA, int32 CellB) const;
+    void SwapCells(int32 CellA, int32 CellB);
+
+    // swap two adjacent cells, only kept if it results in at least one match
+    bool TrySwap(int32 CellA, int32 CellB);
+
+    // matches through the given cells only; the rest of the board must be match free
+    void FindMatchesFrom(const FMatch3CellList& InCells, FMatch3CellList& OutCells) const;
+
+    void ClearCells(const FMatch3CellList& InCells);
+
+    // drop and refill; OutChangedCells gets every cell whose color may have changed
+    // shaped boards drop along the shape's fall segments, around holes and blocked cells
+    void ApplyGravityAndRefill(FMatch3CellList* OutChangedCells = nullptr);
+
+    // one cascade step: score the groups and clear their cells
+    void ApplyClear(const FMatch3GroupBuffer& Groups, int32 CascadeDepth);
+
+    // iterative cascade driver, shared by ResolveTurn and the grid's timer steps
+    // BeginCascade starts the turn with the swap's groups; each StepCascade clears
+    // the groups, drops and refills, then rescans only the changed cells (worklist)
+    // and returns true while there is another step to run under MaxCascadeDepth
+    void BeginCascade(FMatch3GroupBuffer& Groups);
+    bool StepCascade(FMatch3GroupBuffer& Groups, int32& Depth);
+
+    // cells the last StepCascade's drop and refill changed
+    const FMatch3CellList& GetChangedCells() const { return ChangedCells; }
+
+    // commit the turn's score and record its depth
+    // returns true if the board has to be regenerated (no move left or depth cap hit)
+    bool EndCascade(const FMatch3GroupBuffer& Groups, int32 Depth);
+
+    // resolve a whole turn with the driver above, true if the board has to be regenerated
+    bool ResolveCascade(int32& OutDepth);
+
+    // resolve a whole turn and regenerate if needed
+    // returns the cascade depth
+    int32 ResolveTurn();
+
+private:
+    // Cells again with a one cell BorderCell frame, row stride PadStride; the generic
+    // scans read neighbors through pointer steps here and stop at the frame, so
+    // their inner loops have no bounds checks
+    TArray<uint8> Padded;
+    int32 PadStride = 0;
+
+    inline int32 PaddedIndex(int32 Row, int32 Col) const { return (Row + 1) * PadStride + Col + 1; }
+
+    inline void WriteCell(int32 Cell, int32 PaddedCell, uint8 Color)
+    {
+        Hash ^= ZobristKey(Cell, Cells[Cell]) ^ ZobristKey(Cell, Color);
+        Cells[Cell] = Color;
+        Padded[PaddedCell] = Color;
+    }
+
+    // every cell empty (NoCell in holes), frame around them
+    void ResetCells();
+
+    // length of the Color line leaving Start in steps of Step, Start not counted
+    static inline int32 CountRun(const uint8* Start, int32 Step, uint8 Color)
+    {
+        int32 Count = 0;
+        for (const uint8* P = Start + Step; *P == Color; P += Step)
+        {
+            Count++;
+        }
+        return Count;
+    }
+
+    // per cell marks for the generic FindAllMatches
+    mutable TArray<uint8, FMatch3ScratchAllocator> MatchMarks;
+
+    // cells changed by the last drop, the cascade worklist
+    FMatch3CellList ChangedCells;
+
+    // Shuffle scratch: colors before it and old cells grouped by color
+    TArray<uint8, FMatch3ScratchAllocator> ShuffleColors;
+    FMatch3CellList ShuffleCellsByColor;
+
+    // FindMatchesFrom marks: (generation << 3) | flags, so they never need clearing
+    mutable TArray<uint32, FMatch3ScratchAllocator> ScanStamps;
+    mutable uint32 ScanGeneration = 0;
+
+    inline uint8 RandomColor(FRandomStream& InStream) const { return static_cast<uint8>(InStream.RandRange(0, NumColors - 1)); }
+
+    // length of the same-color line through a cell, horizontal and vertical
+    int32 RunLength(int32 Row, int32 Col, int32 DRow, int32 DCol) const;
+    void RegenerateWith(FRandomStream& InStream);
+    void ApplyShapedGravityAndRefill(FMatch3CellList* OutChangedCells);
+    bool HasMatchAt(int32 Row, int32 Col) const;
+
+    // swapping the colors of two adjacent cells would make a match through one of them
+    bool SwapCreatesMatch(int32 r1, int32 c1, int32 r2, int32 c2) const;
+
+    // FindAllMovesWithClears scratch
+    FMatch3CellList MoveCells;
+    FMatch3CellList MoveMatches;
+};
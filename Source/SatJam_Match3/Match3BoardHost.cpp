@@ -0,0 +1,246 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Match3BoardHost.h"
+#include "Match3Snapshot.h"
+#include "Async/ParallelFor.h"
+
+FMatch3BoardHandle UMatch3BoardHost::CreateBoard(int32 Rows, int32 Cols, int32 Seed, const FMatch3ScoreRules& InRules, bool bShuffleDeadBoards,
+    TSharedPtr<const FMatch3BoardShape> Shape, int32 NumColors, int32 MaxCascadeDepth)
+{
+    NumColors = FMath::Clamp(NumColors, FMatch3Board::MinColors, FMatch3Board::MaxColors);
+    const int32 Bits = bPackCells ? FMatch3Snapshot::GetBitsPerCell(NumColors) : 8;
+    const int32 NumBytes = FMath::DivideAndRoundUp(Rows * Cols * Bits, 8);
+
+    // reuse a free slot with room for the cells, otherwise grow every array
+    int32 Slot = INDEX_NONE;
+    for (int32 i = 0; i < FreeSlots.Num(); ++i)
+    {
+        if (CellCapacities[FreeSlots[i]] >= NumBytes)
+        {
+            Slot = FreeSlots[i];
+            FreeSlots.RemoveAtSwap(i, 1, EAllowShrinking::No);
+            break;
+        }
+    }
+
+    if (Slot == INDEX_NONE)
+    {
+        Slot = Generations.Add(0);
+        Alive.Add(false);
+        BoardRows.AddZeroed();
+        BoardCols.AddZeroed();
+        BoardColors.AddZeroed();
+        CellBits.AddZeroed();
+        CellOffsets.Add(CellPool.Num());
+        CellCapacities.Add(NumBytes);
+        Scores.AddZeroed();
+        Turns.AddZeroed();
+        Streams.AddDefaulted();
+        Rules.AddDefaulted();
+        ShuffleDeadBoards.Add(false);
+        MaxCascadeDepths.AddZeroed();
+        Shapes.AddDefaulted();
+        PendingSwaps.Add(INDEX_NONE);
+        CellPool.AddUninitialized(NumBytes);
+    }
+
+    // same start as AMatch3Grid::BeginPlay
+    FMatch3Board Board;
+    Board.Init(Rows, Cols, Seed);
+    Board.SetNumColors(NumColors);
+    Board.SetShape(Shape);
+    Board.Scoring.Rules = InRules;
+    Board.MaxCascadeDepth = MaxCascadeDepth;
+    Board.Regenerate();
+
+    Alive[Slot] = true;
+    BoardRows[Slot] = static_cast<uint16>(Rows);
+    BoardCols[Slot] = static_cast<uint16>(Cols);
+    BoardColors[Slot] = static_cast<uint8>(NumColors);
+    CellBits[Slot] = static_cast<uint8>(Bits);
+    Rules[Slot] = InRules;
+    ShuffleDeadBoards[Slot] = bShuffleDeadBoards;
+    MaxCascadeDepths[Slot] = MaxCascadeDepth;
+    Shapes[Slot] = MoveTemp(Shape);
+    Turns[Slot] = 1;
+    PendingSwaps[Slot] = INDEX_NONE;
+    StoreBoard(Slot, Board);
+    ++NumAlive;
+
+    FMatch3BoardHandle Handle;
+    Handle.Index = Slot;
+    Handle.Generation = Generations[Slot];
+    return Handle;
+}
+
+
+void UMatch3BoardHost::DestroyBoard(FMatch3BoardHandle Handle)
+{
+    if (!IsValid(Handle)) return;
+
+    Alive[Handle.Index] = false;
+    Shapes[Handle.Index].Reset();
+    ++Generations[Handle.Index];
+    FreeSlots.Add(Handle.Index);
+    --NumAlive;
+}
+
+
+bool UMatch3BoardHost::IsValid(FMatch3BoardHandle Handle) const
+{
+    return Alive.IsValidIndex(Handle.Index) && Alive[Handle.Index] && Generations[Handle.Index] == Handle.Generation;
+}
+
+
+bool UMatch3BoardHost::QueueSwap(FMatch3BoardHandle Handle, int32 CellA, int32 CellB)
+{
+    if (!IsValid(Handle) || PendingSwaps[Handle.Index] != INDEX_NONE) return false;
+
+    const int32 Cols = BoardCols[Handle.Index];
+    const int32 NumCells = BoardRows[Handle.Index] * Cols;
+    if (CellA < 0 || CellB < 0 || CellA >= NumCells || CellB >= NumCells) return false;
+
+    const int32 First = FMath::Min(CellA, CellB);
+    PendingSwaps[Handle.Index] = (First << 1) | (FMath::Abs(CellA - CellB) != 1 ? 1 : 0);
+    return true;
+}
+
+
+int32 UMatch3BoardHost::GetScore(FMatch3BoardHandle Handle) const
+{
+    return IsValid(Handle) ? Scores[Handle.Index] : 0;
+}
+
+
+bool UMatch3BoardHost::WriteSnapshot(FMatch3BoardHandle Handle, TArray<uint8>& OutSnapshot) const
+{
+    if (!IsValid(Handle)) return false;
+
+    FMatch3Board Board;
+    LoadBoard(Handle.Index, Board);
+    OutSnapshot.SetNumZeroed(FMatch3Snapshot::GetRecordSize(Board.Rows, Board.Cols, Board.NumColors));
+    return FMatch3Snapshot::Write(Board, false, OutSnapshot);
+}
+
+
+void UMatch3BoardHost::UpdateAll()
+{
+    ActiveSlots.Reset();
+    for (int32 Slot = 0; Slot < PendingSwaps.Num(); ++Slot)
+    {
+        if (PendingSwaps[Slot] != INDEX_NONE && Alive[Slot])
+        {
+            ActiveSlots.Add(Slot);
+        }
+    }
+    if (ActiveSlots.Num() == 0) return;
+
+    const int32 NumTasks = FMath::DivideAndRoundUp(ActiveSlots.Num(), BoardsPerTask);
+    if (Workers.Num() < NumTasks)
+    {
+        Workers.SetNum(NumTasks);
+    }
+    Accepted.SetNumUninitialized(ActiveSlots.Num());
+
+    // boards are independent, each task owns its range of slots and one worker board
+    ParallelFor(NumTasks, [this](int32 Task)
+    {
+        FMatch3Board& Board = Workers[Task];
+        const int32 End = FMath::Min(ActiveSlots.Num(), (Task + 1) * BoardsPerTask);
+        for (int32 i = Task * BoardsPerTask; i < End; ++i)
+        {
+            const int32 Slot = ActiveSlots[i];
+            const int32 Swap = PendingSwaps[Slot];
+            const int32 CellA = Swap >> 1;
+            const int32 CellB = CellA + ((Swap & 1) ? BoardCols[Slot] : 1);
+
+            LoadBoard(Slot, Board);
+            Accepted[i] = Board.TrySwap(CellA, CellB);
+            if (Accepted[i])
+            {
+                Board.ResolveTurn();
+                StoreBoard(Slot, Board);
+                ++Turns[Slot];
+            }
+        }
+    });
+
+    // notify on the game thread, in slot order
+    for (int32 i = 0; i < ActiveSlots.Num(); ++i)
+    {
+        const int32 Slot = ActiveSlots[i];
+        const int32 Swap = PendingSwaps[Slot];
+        PendingSwaps[Slot] = INDEX_NONE;
+
+        FMatch3BoardHandle Handle;
+        Handle.Index = Slot;
+        Handle.Generation = Generations[Slot];
+        OnTurnResolved.Broadcast(Handle, Turns[Slot], Swap, Accepted[i]);
+    }
+}
+
+
+void UMatch3BoardHost::Tick(float DeltaTime)
+{
+    UpdateAll();
+}
+
+
+TStatId UMatch3BoardHost::GetStatId() const
+{
+    RETURN_QUICK_DECLARE_CYCLE_STAT(UMatch3BoardHost, STATGROUP_Tickables);
+}
+
+
+void UMatch3BoardHost::LoadBoard(int32 Slot, FMatch3Board& Board) const
+{
+    const int32 Rows = BoardRows[Slot];
+    const int32 Cols = BoardCols[Slot];
+
+    // Init only when the size changes, so a worker reused for same-size boards allocates nothing
+    if (Board.Rows != Rows || Board.Cols != Cols)
+    {
+        Board.Init(Rows, Cols, 0);
+    }
+
+    if (Board.NumColors != BoardColors[Slot])
+    {
+        Board.SetNumColors(BoardColors[Slot]);
+    }
+
+    // packed cells hold color 0 in the holes, CellsChanged puts NoCell back from the shape
+    Board.Shape = Shapes[Slot];
+    const uint8* Stored = CellPool.GetData() + CellOffsets[Slot];
+    if (CellBits[Slot] == 8)
+    {
+        FMemory::Memcpy(Board.Cells.GetData(), Stored, Rows * Cols);
+    }
+    else
+    {
+        FMatch3Snapshot::UnpackCells(Stored, CellBits[Slot], Board.Cells);
+    }
+    Board.CellsChanged();
+    Board.Score = Scores[Slot];
+    Board.Stream = Streams[Slot];
+    Board.Scoring.Rules = Rules[Slot];
+    Board.bShuffleDeadBoards = ShuffleDeadBoards[Slot];
+    Board.MaxCascadeDepth = MaxCascadeDepths[Slot];
+}
+
+
+void UMatch3BoardHost::StoreBoard(int32 Slot, const FMatch3Board& Board)
+{
+    uint8* Stored = CellPool.GetData() + CellOffsets[Slot];
+    if (CellBits[Slot] == 8)
+    {
+        FMemory::Memcpy(Stored, Board.Cells.GetData(), Board.Num());
+    }
+    else
+    {
+        // stored boards are settled, every cell holds a color or NoCell
+        verify(FMatch3Snapshot::PackCells(Board.Cells, CellBits[Slot], Stored));
+    }
+    Scores[Slot] = Board.Score;
+    Streams[Slot] = Board.Stream;
+}
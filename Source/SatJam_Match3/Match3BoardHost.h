@@ -0,0 +1,102 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Match3Board.h"
+#include "Match3BoardHost.generated.h"
+
+// board slot plus generation, so a handle to a destroyed board never reaches its replacement
+struct FMatch3BoardHandle
+{
+    int32 Index = INDEX_NONE;
+    uint32 Generation = 0;
+
+    bool IsValid() const { return Index != INDEX_NONE; }
+    bool operator==(const FMatch3BoardHandle& Other) const { return Index == Other.Index && Generation == Other.Generation; }
+    bool operator!=(const FMatch3BoardHandle& Other) const { return !(*this == Other); }
+};
+
+// a queued swap was resolved (or rejected) in the last update
+// Sequence counts the board's turns, creation is 1; Swap is packed like FMatch3Replay swaps
+DECLARE_MULTICAST_DELEGATE_FourParams(FOnMatch3HostTurn, FMatch3BoardHandle /*Board*/, int32 /*Sequence*/, int32 /*Swap*/, bool /*bAccepted*/);
+
+// headless host for many boards in one world (dedicated servers running lots of matches)
+// boards live in struct-of-arrays storage and all queued swaps resolve in one batched
+// update per tick, spread over worker threads; each worker loads a board into its own
+// FMatch3Board, runs the usual rules and writes it back
+// an AMatch3Grid with bUseBoardHost attaches to one board for visuals
+UCLASS()
+class SATJAM_MATCH3_API UMatch3BoardHost : public UTickableWorldSubsystem
+{
+    GENERATED_BODY()
+
+public:
+    // boards per worker task in an update
+    static constexpr int32 BoardsPerTask = 64;
+
+    // store boards created from now on at FMatch3Snapshot::GetBitsPerCell of their color
+    // count (2 bits for up to four colors, 3 for up to eight), so more of them stay in
+    // cache; false keeps a byte per cell and skips the unpacking on every load
+    bool bPackCells = true;
+
+    // Shape (same size, null for a rectangle) is shared, boards of one level can pass the same one
+    FMatch3BoardHandle CreateBoard(int32 Rows, int32 Cols, int32 Seed, const FMatch3ScoreRules& Rules, bool bShuffleDeadBoards = false,
+        TSharedPtr<const FMatch3BoardShape> Shape = nullptr, int32 NumColors = FMatch3Board::DefaultNumColors, int32 MaxCascadeDepth = 100);
+    void DestroyBoard(FMatch3BoardHandle Handle);
+    bool IsValid(FMatch3BoardHandle Handle) const;
+
+    int32 NumBoards() const { return NumAlive; }
+
+    // one swap per board per update, false if the handle is stale or one is already queued
+    bool QueueSwap(FMatch3BoardHandle Handle, int32 CellA, int32 CellB);
+
+    int32 GetScore(FMatch3BoardHandle Handle) const;
+
+    // packed board (FMatch3Snapshot) for visuals or networking
+    bool WriteSnapshot(FMatch3BoardHandle Handle, TArray<uint8>& OutSnapshot) const;
+
+    // resolve every queued swap, called from Tick
+    void UpdateAll();
+
+    FOnMatch3HostTurn OnTurnResolved;
+
+    virtual void Tick(float DeltaTime) override;
+    virtual TStatId GetStatId() const override;
+
+private:
+    // struct of arrays, one entry per slot
+    TArray<uint32> Generations;
+    TArray<bool> Alive;
+    TArray<uint16> BoardRows;
+    TArray<uint16> BoardCols;
+    TArray<uint8> BoardColors;
+    TArray<uint8> CellBits;
+    TArray<int32> CellOffsets;
+    TArray<int32> CellCapacities;
+    TArray<int32> Scores;
+    TArray<int32> Turns;
+    TArray<FRandomStream> Streams;
+    TArray<FMatch3ScoreRules> Rules;
+    TArray<bool> ShuffleDeadBoards;
+    TArray<int32> MaxCascadeDepths;
+    TArray<TSharedPtr<const FMatch3BoardShape>> Shapes;
+    TArray<int32> PendingSwaps;
+
+    // colors of every board, each slot owns CellCapacities[i] bytes from CellOffsets[i]
+    // and stores its cells at CellBits[i] each (8 is a byte per cell)
+    TArray<uint8> CellPool;
+
+    TArray<int32> FreeSlots;
+    int32 NumAlive = 0;
+
+    // per update scratch
+    TArray<int32> ActiveSlots;
+    TArray<bool> Accepted;
+    TArray<FMatch3Board> Workers;
+
+    // copy a slot into a worker board and back
+    void LoadBoard(int32 Slot, FMatch3Board& Board) const;
+    void StoreBoard(int32 Slot, const FMatch3Board& Board);
+};
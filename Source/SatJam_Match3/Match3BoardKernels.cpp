@@ -0,0 +1,35 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Match3BoardKernels.h"
+#include "Match3Board.h"
+
+// every size is built for each color count a board can be set to
+template <int32 InRows, int32 InCols>
+static const FMatch3BoardKernel* FindForColors(int32 NumColors)
+{
+    switch (NumColors)
+    {
+    case 3: return &TMatch3BoardKernel<InRows, InCols, 3>::Get();
+    case 4: return &TMatch3BoardKernel<InRows, InCols, 4>::Get();
+    case 5: return &TMatch3BoardKernel<InRows, InCols, 5>::Get();
+    case 6: return &TMatch3BoardKernel<InRows, InCols, 6>::Get();
+    case 7: return &TMatch3BoardKernel<InRows, InCols, 7>::Get();
+    case 8: return &TMatch3BoardKernel<InRows, InCols, 8>::Get();
+    }
+    return nullptr;
+}
+
+
+const FMatch3BoardKernel* Match3Kernels::Find(int32 Rows, int32 Cols, int32 NumColors)
+{
+    static_assert(FMatch3Board::MinColors == 3 && FMatch3Board::MaxColors == 8, "FindForColors covers MinColors to MaxColors");
+
+    if (Rows == 10 && Cols == 6) return FindForColors<10, 6>(NumColors);
+    if (Rows == 6 && Cols == 10) return FindForColors<6, 10>(NumColors);
+    if (Rows == 8 && Cols == 8) return FindForColors<8, 8>(NumColors);
+    if (Rows == 7 && Cols == 7) return FindForColors<7, 7>(NumColors);
+    if (Rows == 6 && Cols == 6) return FindForColors<6, 6>(NumColors);
+
+    return nullptr;
+}
@@ -0,0 +1,203 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Match3Scratch.h"
+
+// rule scans specialized for one board size, picked by FMatch3Board at Init
+// sizes without a kernel use the generic loops in FMatch3Board
+struct FMatch3BoardKernel
+{
+    void (*FindAllMatches)(const uint8* Cells, FMatch3CellList& OutCells);
+    bool (*HasAnyMatches)(const uint8* Cells);
+    bool (*HasPossibleMove)(const uint8* Cells);
+
+    // legal swaps as masks of their first cell: Right swaps i and i + 1, Down swaps i and i + Cols
+    void (*FindAllMoves)(const uint8* Cells, uint64& OutRight, uint64& OutDown);
+};
+
+// fixed-size board kernel on per-color bitboards (one bit per cell, Row * Cols + Col)
+// line and neighbor masks are constexpr and every loop has a compile-time trip count,
+// so there are no bounds checks left in the scans
+template <int32 InRows, int32 InCols, int32 InNumColors>
+struct TMatch3BoardKernel
+{
+    static constexpr int32 NumCells = InRows * InCols;
+
+    static_assert(InRows >= 3 && InCols >= 3, "boards need room for a line of three");
+    static_assert(NumCells <= 64, "bitboard kernels need one uint64 per color");
+    static_assert(InNumColors >= 1 && InNumColors < 255, "color values must stay below FMatch3Board::EmptyCell");
+
+    static constexpr uint64 AllMask = NumCells == 64 ? ~0ull : ((1ull << NumCells) - 1);
+
+    // cells whose column is in [MinCol, MaxCol]
+    static constexpr uint64 ColumnMask(int32 MinCol, int32 MaxCol)
+    {
+        uint64 Mask = 0;
+        for (int32 r = 0; r < InRows; ++r)
+        {
+            for (int32 c = MinCol; c <= MaxCol; ++c)
+            {
+                Mask |= 1ull << (r * InCols + c);
+            }
+        }
+        return Mask;
+    }
+
+    // line starts: a horizontal run of three can start at col <= Cols - 3
+    static constexpr uint64 LineStartMask = ColumnMask(0, InCols - 3);
+
+    // neighbor masks: the neighbor in that direction is on the board (same row for left/right)
+    static constexpr uint64 HasLeft = ColumnMask(1, InCols - 1);
+    static constexpr uint64 HasLeft2 = ColumnMask(2, InCols - 1);
+    static constexpr uint64 HasRight = ColumnMask(0, InCols - 2);
+    static constexpr uint64 HasBoth = ColumnMask(1, InCols - 2);
+
+    static FORCEINLINE void BuildBitboards(const uint8* Cells, uint64 (&Boards)[InNumColors])
+    {
+        for (int32 i = 0; i < InNumColors; ++i)
+        {
+            Boards[i] = 0;
+        }
+        for (int32 i = 0; i < NumCells; ++i)
+        {
+            const uint8 Color = Cells[i];
+            if (Color < InNumColors)
+            {
+                Boards[Color] |= 1ull << i;
+            }
+        }
+    }
+
+    // every cell that is part of a 3+ line of color B
+    static FORCEINLINE uint64 MatchedCells(uint64 B)
+    {
+        const uint64 H = B & (B >> 1) & (B >> 2) & LineStartMask;
+        const uint64 V = B & (B >> InCols) & (B >> (2 * InCols));
+        return H | (H << 1) | (H << 2) | V | (V << InCols) | (V << (2 * InCols));
+    }
+
+    static void FindAllMatches(const uint8* Cells, FMatch3CellList& OutCells)
+    {
+        uint64 Boards[InNumColors];
+        BuildBitboards(Cells, Boards);
+
+        uint64 Matched = 0;
+        for (int32 i = 0; i < InNumColors; ++i)
+        {
+            Matched |= MatchedCells(Boards[i]);
+        }
+
+        OutCells.Reset();
+        while (Matched)
+        {
+            OutCells.Add(static_cast<int32>(FMath::CountTrailingZeros64(Matched)));
+            Matched &= Matched - 1;
+        }
+    }
+
+    static bool HasAnyMatches(const uint8* Cells)
+    {
+        uint64 Boards[InNumColors];
+        BuildBitboards(Cells, Boards);
+
+        for (int32 i = 0; i < InNumColors; ++i)
+        {
+            if (MatchedCells(Boards[i])) return true;
+        }
+        return false;
+    }
+
+    // a swap moves color X into cell p from a neighbor q; it makes a match if p
+    // completes a line of X without using q (q now holds the other color)
+    // the masks below have bit p set where that holds, per direction q is in
+    struct FMoveMasks
+    {
+        uint64 FromRight;
+        uint64 FromLeft;
+        uint64 FromAbove;
+        uint64 FromBelow;
+    };
+
+    static FORCEINLINE FMoveMasks MoveMasks(uint64 B, uint64 Occupied)
+    {
+        const uint64 Target = Occupied & ~B;
+
+        // p completes a line with these pairs of neighbors
+        const uint64 PairLeft = (B << 1) & (B << 2) & HasLeft2;
+        const uint64 PairRight = (B >> 1) & (B >> 2) & LineStartMask;
+        const uint64 PairLeftRight = (B << 1) & (B >> 1) & HasBoth;
+        const uint64 PairUp = (B << InCols) & (B << (2 * InCols)) & AllMask;
+        const uint64 PairDown = (B >> InCols) & (B >> (2 * InCols));
+        const uint64 PairUpDown = (B << InCols) & (B >> InCols) & AllMask;
+
+        const uint64 Vertical = PairUp | PairDown | PairUpDown;
+        const uint64 Horizontal = PairLeft | PairRight | PairLeftRight;
+
+        FMoveMasks Masks;
+        Masks.FromRight = (B >> 1) & HasRight & Target & (PairLeft | Vertical);
+        Masks.FromLeft = (B << 1) & HasLeft & Target & (PairRight | Vertical);
+        Masks.FromAbove = (B << InCols) & AllMask & Target & (PairDown | Horizontal);
+        Masks.FromBelow = (B >> InCols) & Target & (PairUp | Horizontal);
+        return Masks;
+    }
+
+    static FORCEINLINE uint64 OccupiedCells(const uint64 (&Boards)[InNumColors])
+    {
+        uint64 Occupied = 0;
+        for (int32 i = 0; i < InNumColors; ++i)
+        {
+            Occupied |= Boards[i];
+        }
+        return Occupied;
+    }
+
+    static bool HasPossibleMove(const uint8* Cells)
+    {
+        uint64 Boards[InNumColors];
+        BuildBitboards(Cells, Boards);
+        const uint64 Occupied = OccupiedCells(Boards);
+
+        for (int32 i = 0; i < InNumColors; ++i)
+        {
+            const FMoveMasks Masks = MoveMasks(Boards[i], Occupied);
+            if (Masks.FromRight | Masks.FromLeft | Masks.FromAbove | Masks.FromBelow) return true;
+        }
+        return false;
+    }
+
+    // the same masks for every color, shifted so each swap is keyed by its first cell
+    static void FindAllMoves(const uint8* Cells, uint64& OutRight, uint64& OutDown)
+    {
+        uint64 Boards[InNumColors];
+        BuildBitboards(Cells, Boards);
+        const uint64 Occupied = OccupiedCells(Boards);
+
+        uint64 Right = 0;
+        uint64 Down = 0;
+        for (int32 i = 0; i < InNumColors; ++i)
+        {
+            const FMoveMasks Masks = MoveMasks(Boards[i], Occupied);
+            Right |= Masks.FromRight | (Masks.FromLeft >> 1);
+            Down |= Masks.FromBelow | (Masks.FromAbove >> InCols);
+        }
+
+        OutRight = Right;
+        OutDown = Down;
+    }
+
+    static const FMatch3BoardKernel& Get()
+    {
+        static constexpr FMatch3BoardKernel Kernel = { &FindAllMatches, &HasAnyMatches, &HasPossibleMove, &FindAllMoves };
+        return Kernel;
+    }
+};
+
+namespace Match3Kernels
+{
+    // specialized kernel for a board size and color count (one bitboard per color),
+    // nullptr for the generic fallback; the sizes our levels use are instantiated
+    // for every color count in Match3BoardKernels.cpp only
+    SATJAM_MATCH3_API const FMatch3BoardKernel* Find(int32 Rows, int32 Cols, int32 NumColors);
+}
@@ -0,0 +1,141 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Match3BoardPool.h"
+#include "HAL/Event.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/RunnableThread.h"
+
+FMatch3BoardPool::FMatch3BoardPool(int32 InRows, int32 InCols, int32 InNumColors, int32 InCapacity, int32 Seed)
+    : Rows(InRows)
+    , Cols(InCols)
+    , NumColors(InNumColors)
+    , Capacity(FMath::Max(1, InCapacity))
+    , SeedStream(Seed)
+    , MissStream(Seed ^ 0x2545F491)
+{
+    Ready.Reserve(Capacity);
+    Worker.Init(Rows, Cols, 0);
+    Worker.SetNumColors(NumColors);
+
+    WakeEvent = FPlatformProcess::GetSynchEventFromPool(false);
+    Thread = FRunnableThread::Create(this, *FString::Printf(TEXT("Match3BoardPool_%dx%d_%d"), Rows, Cols, NumColors), 0, TPri_BelowNormal);
+}
+
+
+FMatch3BoardPool::~FMatch3BoardPool()
+{
+    if (Thread)
+    {
+        // Kill calls Stop and waits for Run to return
+        Thread->Kill(true);
+        delete Thread;
+        Thread = nullptr;
+    }
+
+    FPlatformProcess::ReturnSynchEventToPool(WakeEvent);
+    WakeEvent = nullptr;
+}
+
+
+bool FMatch3BoardPool::TryPop(FMatch3Board& Board, int32& OutRegenSeed)
+{
+    check(Board.Rows == Rows && Board.Cols == Cols && Board.NumColors == NumColors);
+
+    {
+        FScopeLock ScopeLock(&Lock);
+        if (Ready.Num() == 0)
+        {
+            Stats.Misses++;
+            return false;
+        }
+
+        // oldest first
+        FEntry& Entry = Ready[0];
+        OutRegenSeed = Entry.Seed;
+        Board.Cells = Entry.Cells;
+        Ready.RemoveAt(0, 1, EAllowShrinking::No);
+        Stats.Hits++;
+    }
+    Board.CellsChanged();
+
+    WakeEvent->Trigger();
+    return true;
+}
+
+
+void FMatch3BoardPool::Regenerate(FMatch3Board& Board, int32& OutRegenSeed)
+{
+    OutRegenSeed = static_cast<int32>(MissStream.GetUnsignedInt());
+    Board.RegenerateFromSeed(OutRegenSeed);
+}
+
+
+FMatch3BoardPoolStats FMatch3BoardPool::GetStats() const
+{
+    FScopeLock ScopeLock(&Lock);
+    FMatch3BoardPoolStats Result = Stats;
+    Result.Ready = Ready.Num();
+    return Result;
+}
+
+
+uint32 FMatch3BoardPool::Run()
+{
+    while (!bStopping)
+    {
+        bool bFull;
+        {
+            FScopeLock ScopeLock(&Lock);
+            bFull = Ready.Num() >= Capacity;
+        }
+        if (bFull)
+        {
+            WakeEvent->Wait();
+            continue;
+        }
+
+        // generate outside the lock, the game thread only waits for the copy
+        const int32 Seed = static_cast<int32>(SeedStream.GetUnsignedInt());
+        Worker.RegenerateFromSeed(Seed);
+
+        FScopeLock ScopeLock(&Lock);
+        FEntry& Entry = Ready.AddDefaulted_GetRef();
+        Entry.Seed = Seed;
+        Entry.Cells = Worker.Cells;
+        Stats.Generated++;
+    }
+    return 0;
+}
+
+
+void FMatch3BoardPool::Stop()
+{
+    bStopping = true;
+    WakeEvent->Trigger();
+}
+
+
+void UMatch3BoardPoolSubsystem::Deinitialize()
+{
+    for (const TPair<FIntVector, TUniquePtr<FMatch3BoardPool>>& Pair : Pools)
+    {
+        const FMatch3BoardPoolStats Stats = Pair.Value->GetStats();
+        UE_LOG(LogTemp, Log, TEXT("Board pool %dx%d, %d colors: %d hits, %d misses, %d generated"),
+            Pair.Key.X, Pair.Key.Y, Pair.Key.Z, Stats.Hits, Stats.Misses, Stats.Generated);
+    }
+    Pools.Empty();
+
+    Super::Deinitialize();
+}
+
+
+FMatch3BoardPool* UMatch3BoardPoolSubsystem::GetPool(int32 Rows, int32 Cols, int32 NumColors)
+{
+    TUniquePtr<FMatch3BoardPool>& Pool = Pools.FindOrAdd(FIntVector(Rows, Cols, NumColors));
+    if (!Pool)
+    {
+        Pool = MakeUnique<FMatch3BoardPool>(Rows, Cols, NumColors, PoolCapacity, FMath::Rand());
+    }
+    return Pool.Get();
+}
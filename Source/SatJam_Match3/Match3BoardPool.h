@@ -0,0 +1,90 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "Match3Board.h"
+#include "Match3BoardPool.generated.h"
+
+class FRunnableThread;
+class FEvent;
+
+struct FMatch3BoardPoolStats
+{
+    int32 Hits = 0;
+    int32 Misses = 0;
+    int32 Generated = 0;
+    int32 Ready = 0;
+};
+
+// ready boards for one size and color count, made on a worker thread with FMatch3Board::RegenerateFromSeed
+// (no matches, at least one move); a board is its seed plus colors, so a replay only
+// records the seed
+class SATJAM_MATCH3_API FMatch3BoardPool : public FRunnable
+{
+public:
+    FMatch3BoardPool(int32 InRows, int32 InCols, int32 InNumColors, int32 InCapacity, int32 Seed);
+    virtual ~FMatch3BoardPool();
+
+    // apply a ready board to Board (same size and colors), false on a miss
+    bool TryPop(FMatch3Board& Board, int32& OutRegenSeed);
+
+    // a miss regenerates on the caller's thread from a fresh seed
+    void Regenerate(FMatch3Board& Board, int32& OutRegenSeed);
+
+    FMatch3BoardPoolStats GetStats() const;
+
+    // FRunnable
+    virtual uint32 Run() override;
+    virtual void Stop() override;
+
+private:
+    struct FEntry
+    {
+        int32 Seed = 0;
+        TArray<uint8> Cells;
+    };
+
+    const int32 Rows;
+    const int32 Cols;
+    const int32 NumColors;
+    const int32 Capacity;
+
+    mutable FCriticalSection Lock;
+    TArray<FEntry> Ready;
+    FMatch3BoardPoolStats Stats;
+
+    // worker side
+    FRandomStream SeedStream;
+    FMatch3Board Worker;
+
+    // caller side, seeds for misses
+    FRandomStream MissStream;
+
+    FEvent* WakeEvent = nullptr;
+    FRunnableThread* Thread = nullptr;
+    TAtomic<bool> bStopping { false };
+};
+
+// board pools by size and color count, kept for the whole game instance so a level start finds
+// boards made while the previous level was played
+UCLASS()
+class SATJAM_MATCH3_API UMatch3BoardPoolSubsystem : public UGameInstanceSubsystem
+{
+    GENERATED_BODY()
+
+public:
+    // ready boards kept per pool
+    static constexpr int32 PoolCapacity = 4;
+
+    virtual void Deinitialize() override;
+
+    // pool for a board size and color count, started on first use
+    FMatch3BoardPool* GetPool(int32 Rows, int32 Cols, int32 NumColors);
+
+private:
+    // X = rows, Y = cols, Z = colors
+    TMap<FIntVector, TUniquePtr<FMatch3BoardPool>> Pools;
+};
@@ -0,0 +1,71 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Match3BoardShape.h"
+
+TSharedRef<const FMatch3BoardShape> FMatch3BoardShape::Make(int32 InRows, int32 InCols, TArray<EMatch3CellKind> InKinds)
+{
+    check(InKinds.Num() == InRows * InCols);
+
+    TSharedRef<FMatch3BoardShape> Shape = MakeShared<FMatch3BoardShape>();
+    Shape->Rows = InRows;
+    Shape->Cols = InCols;
+    Shape->Kinds = MoveTemp(InKinds);
+    Shape->FallRows.Reserve(InRows * InCols);
+
+    for (int32 c = 0; c < InCols; ++c)
+    {
+        // walk up the column, a blocked cell closes the segment below it
+        FSegment Segment;
+        Segment.Col = c;
+        Segment.First = Shape->FallRows.Num();
+        for (int32 r = InRows - 1; r >= 0; --r)
+        {
+            const int32 Cell = r * InCols + c;
+            const EMatch3CellKind Kind = Shape->Kinds[Cell];
+            if (Kind == EMatch3CellKind::Cell)
+            {
+                Shape->FallRows.Add(r);
+                Segment.Num++;
+                Shape->NumCells++;
+            }
+            else if (Kind == EMatch3CellKind::Blocked)
+            {
+                if (Segment.Num > 0)
+                {
+                    Shape->Segments.Add(Segment);
+                }
+                Segment.First = Shape->FallRows.Num();
+                Segment.Num = 0;
+            }
+        }
+        if (Segment.Num > 0)
+        {
+            Shape->Segments.Add(Segment);
+        }
+    }
+
+    return Shape;
+}
+
+
+TSharedRef<const FMatch3BoardShape> FMatch3BoardShape::Make(int32 InRows, int32 InCols, TConstArrayView<FIntPoint> Holes, TConstArrayView<FIntPoint> Blocked)
+{
+    TArray<EMatch3CellKind> Kinds;
+    Kinds.Init(EMatch3CellKind::Cell, InRows * InCols);
+
+    auto Mark = [&](TConstArrayView<FIntPoint> Positions, EMatch3CellKind Kind)
+        {
+            for (const FIntPoint& Position : Positions)
+            {
+                if (Position.X >= 0 && Position.X < InRows && Position.Y >= 0 && Position.Y < InCols)
+                {
+                    Kinds[Position.X * InCols + Position.Y] = Kind;
+                }
+            }
+        };
+    Mark(Holes, EMatch3CellKind::Hole);
+    Mark(Blocked, EMatch3CellKind::Blocked);
+
+    return Make(InRows, InCols, MoveTemp(Kinds));
+}
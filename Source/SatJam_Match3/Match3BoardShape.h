@@ -0,0 +1,52 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// what sits at one position of a shaped board
+enum class EMatch3CellKind : uint8
+{
+    Cell,       // a normal cell holding a tile
+    Hole,       // no cell, tiles fall through it
+    Blocked     // no cell, tiles rest on it and refills start again below it
+};
+
+// which cells of a Rows x Cols board exist, built once per level and shared by
+// every board of that level (FMatch3Board::Shape)
+// holes and blocked cells hold FMatch3Board::NoCell, which never matches, so
+// runs break at them in every scan without a table of their own; gravity runs
+// on the fall segments below instead of whole columns
+struct SATJAM_MATCH3_API FMatch3BoardShape
+{
+    // cells of one column between blocked cells (holes skipped), bottom first;
+    // tiles fall within a segment and refills enter at its top
+    struct FSegment
+    {
+        int32 Col = 0;
+        int32 First = 0;
+        int32 Num = 0;
+    };
+
+    int32 Rows = 0;
+    int32 Cols = 0;
+
+    // Row * Cols + Col
+    TArray<EMatch3CellKind> Kinds;
+
+    // column by column, bottom segment first; the rows of a segment's cells are
+    // FallRows[First .. First + Num)
+    TArray<FSegment> Segments;
+    TArray<int32> FallRows;
+
+    // cells that hold tiles
+    int32 NumCells = 0;
+
+    // Kinds must have Rows * Cols entries
+    static TSharedRef<const FMatch3BoardShape> Make(int32 InRows, int32 InCols, TArray<EMatch3CellKind> InKinds);
+
+    // from level data, X = row and Y = column; positions outside the board are ignored
+    static TSharedRef<const FMatch3BoardShape> Make(int32 InRows, int32 InCols, TConstArrayView<FIntPoint> Holes, TConstArrayView<FIntPoint> Blocked);
+
+    inline bool IsCell(int32 Cell) const { return Kinds[Cell] == EMatch3CellKind::Cell; }
+};
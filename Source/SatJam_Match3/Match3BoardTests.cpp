@@ -0,0 +1,273 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Match3Board.h"
+#include "Match3BoardShape.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    // sizes without a kernel, so the scans walk the padded copy
+    const FIntPoint PaddedSizes[] = { { 9, 9 }, { 12, 12 }, { 5, 7 }, { 7, 5 }, { 3, 3 }, { 32, 32 } };
+
+    // the rules written out with bounds checks, on the dense cells
+    struct FReference
+    {
+        TArray<uint8> Cells;
+        int32 Rows = 0;
+        int32 Cols = 0;
+
+        explicit FReference(const FMatch3Board& Board)
+            : Cells(Board.Cells), Rows(Board.Rows), Cols(Board.Cols)
+        {
+        }
+
+        uint8 At(int32 r, int32 c) const
+        {
+            return r >= 0 && r < Rows && c >= 0 && c < Cols ? Cells[r * Cols + c] : FMatch3Board::NoCell;
+        }
+
+        bool HasMatchAt(int32 Cell) const
+        {
+            const int32 r = Cell / Cols;
+            const int32 c = Cell % Cols;
+            const uint8 Color = At(r, c);
+            if (Color >= FMatch3Board::MaxColors) return false;
+
+            int32 Horizontal = 1;
+            for (int32 i = c - 1; At(r, i) == Color; --i) ++Horizontal;
+            for (int32 i = c + 1; At(r, i) == Color; ++i) ++Horizontal;
+            int32 Vertical = 1;
+            for (int32 i = r - 1; At(i, c) == Color; --i) ++Vertical;
+            for (int32 i = r + 1; At(i, c) == Color; ++i) ++Vertical;
+            return Horizontal >= 3 || Vertical >= 3;
+        }
+
+        TArray<int32> FindAllMatches() const
+        {
+            TArray<int32> Result;
+            for (int32 Cell = 0; Cell < Cells.Num(); ++Cell)
+            {
+                if (HasMatchAt(Cell)) Result.Add(Cell);
+            }
+            return Result;
+        }
+
+        // holes never move; a settled board only matches through the swapped cells
+        bool SwapCreatesMatch(int32 CellA, int32 CellB)
+        {
+            if (Cells[CellA] == FMatch3Board::NoCell || Cells[CellB] == FMatch3Board::NoCell) return false;
+            Swap(Cells[CellA], Cells[CellB]);
+            const bool bMatch = HasMatchAt(CellA) || HasMatchAt(CellB);
+            Swap(Cells[CellA], Cells[CellB]);
+            return bMatch;
+        }
+
+        // horizontal swaps first, then vertical, each by CellA
+        TArray<FIntPoint> FindAllMoves()
+        {
+            TArray<FIntPoint> Result;
+            for (int32 Cell = 0; Cell < Cells.Num(); ++Cell)
+            {
+                if (Cell % Cols + 1 < Cols && SwapCreatesMatch(Cell, Cell + 1)) Result.Add({ Cell, Cell + 1 });
+            }
+            for (int32 Cell = 0; Cell + Cols < Cells.Num(); ++Cell)
+            {
+                if (SwapCreatesMatch(Cell, Cell + Cols)) Result.Add({ Cell, Cell + Cols });
+            }
+            return Result;
+        }
+    };
+
+    void FillAnyColors(FMatch3Board& Board, FRandomStream& Stream)
+    {
+        for (uint8& Color : Board.Cells)
+        {
+            Color = static_cast<uint8>(Stream.RandRange(0, Board.NumColors - 1));
+        }
+        Board.CellsChanged();
+    }
+
+    TArray<int32> Sorted(const FMatch3CellList& Cells)
+    {
+        TArray<int32> Result(Cells.GetData(), Cells.Num());
+        Result.Sort();
+        return Result;
+    }
+
+    // Hash recomputed from scratch
+    uint64 FullHash(const FMatch3Board& Board)
+    {
+        uint64 Result = 0;
+        for (int32 Cell = 0; Cell < Board.Num(); ++Cell)
+        {
+            Result ^= FMatch3Board::ZobristKey(Cell, Board.Cells[Cell]);
+        }
+        return Result;
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMatch3PaddedScanTest, "SatJam.Match3.Board.PaddedScans",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FMatch3PaddedScanTest::RunTest(const FString& Parameters)
+{
+    FMatch3CellList Cells;
+    FMatch3CellList Matches;
+    FMatch3MoveList Moves;
+
+    for (const FIntPoint& Size : PaddedSizes)
+    {
+        for (int32 bShaped = 0; bShaped < 2; ++bShaped)
+        {
+            FMatch3Board Board;
+            Board.Init(Size.X, Size.Y, Size.X * Size.Y);
+            Board.SetNumColors(3 + (Size.X + bShaped) % 6);
+            if (!TestTrue(TEXT("size has no kernel"), Board.Kernel == nullptr)) continue;
+
+            // a hole in a corner and one inside, which the scans must step over
+            if (bShaped)
+            {
+                const FIntPoint Holes[] = { { 0, 0 }, { Size.X / 2, Size.Y / 2 } };
+                Board.SetShape(FMatch3BoardShape::Make(Size.X, Size.Y, Holes, TConstArrayView<FIntPoint>()));
+            }
+
+            FRandomStream Stream(Size.X * 100 + Size.Y + bShaped);
+            for (int32 i = 0; i < 100; ++i)
+            {
+                // random boards have matches, generated ones only moves
+                if (i % 2 == 0)
+                {
+                    FillAnyColors(Board, Stream);
+                }
+                else
+                {
+                    Board.RegenerateFromSeed(static_cast<int32>(Stream.GetUnsignedInt()));
+                }
+
+                FReference Reference(Board);
+                Board.FindAllMatches(Cells);
+                TestTrue(TEXT("FindAllMatches"), Sorted(Cells) == Reference.FindAllMatches());
+                TestEqual(TEXT("HasAnyMatches"), Board.HasAnyMatches(), Reference.FindAllMatches().Num() > 0);
+                if (i % 2 == 0) continue;
+
+                // settled board: moves, swaps and the worklist rescan
+                const TArray<FIntPoint> Expected = Reference.FindAllMoves();
+                TestEqual(TEXT("HasPossibleMove"), Board.HasPossibleMove(), Expected.Num() > 0);
+
+                Board.FindAllMoves(Moves);
+                if (TestEqual(TEXT("FindAllMoves count"), Moves.Moves.Num(), Expected.Num()))
+                {
+                    for (int32 m = 0; m < Expected.Num(); ++m)
+                    {
+                        TestTrue(TEXT("FindAllMoves order"), Moves.Moves[m].CellA == Expected[m].X && Moves.Moves[m].CellB == Expected[m].Y);
+                    }
+                }
+
+                for (int32 Cell = 0; Cell < Board.Num(); ++Cell)
+                {
+                    const int32 Neighbors[] = { Cell % Board.Cols + 1 < Board.Cols ? Cell + 1 : INDEX_NONE, Cell + Board.Cols < Board.Num() ? Cell + Board.Cols : INDEX_NONE };
+                    for (int32 Other : Neighbors)
+                    {
+                        if (Other == INDEX_NONE) continue;
+
+                        const bool bLegal = Reference.SwapCreatesMatch(Cell, Other);
+                        if (!TestEqual(TEXT("TrySwap"), Board.TrySwap(Cell, Other), bLegal) || !bLegal) continue;
+
+                        // the swap went through SwapCells, so the padded copy must follow it
+                        const FMatch3CellList Swapped = { Cell, Other };
+                        Board.FindMatchesFrom(Swapped, Matches);
+                        TestTrue(TEXT("FindMatchesFrom"), Sorted(Matches) == FReference(Board).FindAllMatches());
+                        Board.SwapCells(Cell, Other);
+                    }
+                }
+                TestTrue(TEXT("board unchanged after the swaps"), Board.Cells == Reference.Cells);
+            }
+        }
+    }
+    return true;
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMatch3IncrementalHashTest, "SatJam.Match3.Board.IncrementalHash",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FMatch3IncrementalHashTest::RunTest(const FString& Parameters)
+{
+    // sizes with and without a kernel, plain and shaped
+    const FIntPoint Sizes[] = { { 10, 6 }, { 8, 8 }, { 9, 9 }, { 5, 7 } };
+    FMatch3MoveList Moves;
+    FMatch3CellList Source;
+
+    for (const FIntPoint& Size : Sizes)
+    {
+        for (int32 bShaped = 0; bShaped < 2; ++bShaped)
+        {
+            FMatch3Board Board;
+            Board.Init(Size.X, Size.Y, Size.X * 7 + bShaped);
+            Board.SetNumColors(4 + bShaped);
+            Board.MaxCascadeDepth = 3;
+            if (bShaped)
+            {
+                const FIntPoint Holes[] = { { 0, 0 }, { Size.X / 2, Size.Y / 2 } };
+                const FIntPoint Blocked[] = { { Size.X - 1, 1 } };
+                Board.SetShape(FMatch3BoardShape::Make(Size.X, Size.Y, Holes, Blocked));
+            }
+            Board.Regenerate();
+            TestEqual(TEXT("after Regenerate"), Board.Hash, FullHash(Board));
+
+            FRandomStream Picks(Size.X + Size.Y + bShaped);
+            for (int32 Turn = 0; Turn < 200; ++Turn)
+            {
+                // a refused swap is put back
+                const int32 Cell = Picks.RandHelper(Board.Num());
+                const int32 Right = Cell % Board.Cols + 1 < Board.Cols ? Cell + 1 : Cell - 1;
+                const uint64 Before = Board.Hash;
+                if (!Board.TrySwap(Cell, Right))
+                {
+                    TestEqual(TEXT("after a refused swap"), Board.Hash, Before);
+                }
+                else
+                {
+                    Board.SwapCells(Cell, Right);
+                }
+
+                Board.FindAllMoves(Moves);
+                if (!TestTrue(TEXT("settled board has a move"), Moves.Moves.Num() > 0)) break;
+                const FMatch3Move& Move = Moves.Moves[Picks.RandHelper(Moves.Moves.Num())];
+                Board.TrySwap(Move.CellA, Move.CellB);
+                if (!TestEqual(TEXT("after a swap"), Board.Hash, FullHash(Board))) break;
+
+                int32 Depth = 0;
+                const bool bRegenerate = Board.ResolveCascade(Depth);
+                if (!TestEqual(TEXT("after a cascade"), Board.Hash, FullHash(Board))) break;
+
+                // every few turns, and on dead boards, the other ways a board is replaced
+                if (bRegenerate || Turn % 10 == 0)
+                {
+                    if (Board.Shuffle(&Source))
+                    {
+                        TestEqual(TEXT("after Shuffle"), Board.Hash, FullHash(Board));
+                    }
+                    Board.RegenerateFromSeed(static_cast<int32>(Picks.GetUnsignedInt()));
+                    TestEqual(TEXT("after RegenerateFromSeed"), Board.Hash, FullHash(Board));
+                    Board.Regenerate();
+                    TestEqual(TEXT("after Regenerate"), Board.Hash, FullHash(Board));
+                }
+            }
+
+            // copies carry the hash over
+            FMatch3Board Copy;
+            Copy.CopyFrom(Board);
+            TestEqual(TEXT("after CopyFrom"), Copy.Hash, FullHash(Board));
+            Copy.Regenerate();
+            Copy.CopyCellsFrom(Board);
+            TestEqual(TEXT("after CopyCellsFrom"), Copy.Hash, FullHash(Board));
+        }
+    }
+    return true;
+}
+
+#endif
@@ -0,0 +1,68 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Match3CommandletBase.h"
+#include "HAL/FileManager.h"
+
+static constexpr auto HelpSwitch = TEXT("help");
+static constexpr auto OutputSwitch = TEXT("output");
+
+UMatch3CommandletBase::UMatch3CommandletBase()
+{
+    IsClient = false;
+    IsEditor = false;
+    IsServer = false;
+    LogToConsole = true;
+    ShowErrorCount = false;
+
+    HelpParamNames.Add(OutputSwitch);
+    HelpParamDescriptions.Add(TEXT("[Required] The file path to write the command output."));
+
+    HelpParamNames.Add(HelpSwitch);
+    HelpParamDescriptions.Add(TEXT("[Optional] Print this help message and quit the commandlet immediately."));
+}
+
+
+void UMatch3CommandletBase::PrintHelp() const
+{
+    UE_LOG(LogTemp, Display, TEXT("%s"), *HelpDescription);
+    UE_LOG(LogTemp, Display, TEXT("Usage: %s"), *HelpUsage);
+    UE_LOG(LogTemp, Display, TEXT("Parameters:"));
+    for (int32 i = 0; i < HelpParamNames.Num(); ++i)
+    {
+        UE_LOG(LogTemp, Display, TEXT("\t-%s: %s"), *HelpParamNames[i], *HelpParamDescriptions[i]);
+    }
+}
+
+
+int32 UMatch3CommandletBase::Main(const FString& Params)
+{
+    TArray<FString> Tokens;
+    TArray<FString> Switches;
+    TMap<FString, FString> ParamVals;
+
+    ParseCommandLine(*Params, Tokens, Switches, ParamVals);
+
+    if (Switches.Contains(HelpSwitch))
+    {
+        PrintHelp();
+        return 0;
+    }
+
+    const FString FullPath = ParamVals.FindRef(OutputSwitch);
+    if (FullPath.IsEmpty())
+    {
+        UE_LOG(LogTemp, Error, TEXT("Missing file output parameter."));
+        PrintHelp();
+        return 1;
+    }
+
+    TUniquePtr<FArchive> OutArchive(IFileManager::Get().CreateFileWriter(*FullPath));
+    if (!OutArchive)
+    {
+        UE_LOG(LogTemp, Error, TEXT("Failed to create output file: %s."), *FullPath);
+        return 1;
+    }
+
+    return Run(Tokens, Switches, ParamVals, *OutArchive);
+}
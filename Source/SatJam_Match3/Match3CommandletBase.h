@@ -0,0 +1,30 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "Match3CommandletBase.generated.h"
+
+// shared front end for Match3 commandlets, after the VisualStudioTools plugin's base:
+// parses the command line, handles -help and opens the required -output file,
+// then hands everything to Run
+UCLASS(Abstract)
+class SATJAM_MATCH3_API UMatch3CommandletBase : public UCommandlet
+{
+    GENERATED_BODY()
+
+public:
+    virtual int32 Main(const FString& Params) override;
+
+protected:
+    UMatch3CommandletBase();
+
+    void PrintHelp() const;
+
+    virtual int32 Run(
+        TArray<FString>& Tokens,
+        TArray<FString>& Switches,
+        TMap<FString, FString>& ParamVals,
+        FArchive& OutArchive) PURE_VIRTUAL(UMatch3CommandletBase::Run, return 0;);
+};
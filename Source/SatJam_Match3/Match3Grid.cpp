@@ -2,56 +2,279 @@
 
 
 #include "Match3Grid.h"
+#include "Match3Snapshot.h"
+#include "Match3NetDelta.h"
+#include "Match3PlayerController.h"
+#include "Match3BoardPool.h"
+#include "Engine/GameInstance.h"
 #include "Engine/World.h"
+#include "Misc/App.h"
+#include "Misc/DateTime.h"
+#include "Misc/Paths.h"
 #include "Kismet/KismetMathLibrary.h"
 #include "TimerManager.h"
 
+static_assert(static_cast<int32>(ETileColor::Pink) + 1 == FMatch3Board::MaxColors, "every board color needs a tile color");
+
 AMatch3Grid::AMatch3Grid()
 {
-    PrimaryActorTick.bCanEverTick = false;
+    // only ticks to drain the simulation thread or poll the AI
+    PrimaryActorTick.bCanEverTick = true;
+    PrimaryActorTick.bStartWithTickEnabled = false;
+
+    for (int32& Sequence : NetHistorySequence)
+    {
+        Sequence = INDEX_NONE;
+    }
 }
 
 void AMatch3Grid::BeginPlay()
 {
     Super::BeginPlay();
 
-    // initialize array
+    // initialize board and array
+    const int32 BoardSeed = Seed != 0 ? Seed : FMath::Rand();
+    Board.Init(Rows, Cols, BoardSeed);
+
+    // Blueprints made before the extra colors only set the first four materials,
+    // play with the colors the tile class can show rather than two that look alike
+    const AMatchTile* TileDefaults = TileClass ? TileClass->GetDefaultObject<AMatchTile>() : nullptr;
+    const int32 NumMaterials = TileDefaults ? TileDefaults->GetNumColorMaterials() : FMatch3Board::MaxColors;
+    if (NumColors > NumMaterials)
+    {
+        const int32 Clamped = FMath::Max(NumMaterials, FMatch3Board::MinColors);
+        UE_LOG(LogTemp, Warning, TEXT("%s: NumColors is %d but %s has materials for %d; playing with %d."),
+            *GetName(), NumColors, *TileClass->GetName(), NumMaterials, Clamped);
+        NumColors = Clamped;
+    }
+    Board.SetNumColors(NumColors);
+    if (HoleCells.Num() > 0 || BlockedCells.Num() > 0)
+    {
+        Board.SetShape(FMatch3BoardShape::Make(Rows, Cols, HoleCells, BlockedCells));
+    }
+    Board.Scoring.Rules.PointsPerClear = PointsPerClear;
+    Board.Scoring.Rules.CascadeBonusPercent = CascadeBonusPercent;
+    Board.MaxCascadeDepth = MaxCascadeDepth;
+    Board.bShuffleDeadBoards = bShuffleDeadBoards;
+    Replay.Begin(Board, BoardSeed);
+    if (bRecordTelemetry)
+    {
+        const FString Filename = FPaths::ProjectSavedDir() / TEXT("Telemetry")
+            / FString::Printf(TEXT("%s_%s.m3tl"), *GetName(), *FDateTime::Now().ToString());
+        Telemetry = MakeUnique<FMatch3TelemetryWriter>(Filename, Rows, Cols, BoardSeed);
+    }
+    if (bAiPlayer && !IsNetClient())
+    {
+        FMatch3MctsSettings AiSettings;
+        AiSettings.TimeBudgetSeconds = AiMoveBudget;
+        Ai = MakeUnique<FMatch3MctsPlayer>(AiSettings);
+        SetActorTickEnabled(true);
+    }
+    PendingGroups.Reserve(Rows * Cols);
+    QueuedSwaps.Reset();
+    QueuedSwaps.Reserve(MaxQueuedSwaps);
+
+    Score = 0;
+    bHasWon = false;
+
     GridArray.SetNumZeroed(Rows * Cols);
+    bBoardReady = true;
+
+    // clients wait for the server's board, which may have arrived already
+    if (IsNetClient())
+    {
+        bRecordReplay = false;
+        bInputLocked = true;
+        PlayNetTurns();
+        return;
+    }
+
+    // the host generates the board from the same seed and resolves every swap,
+    // the local board replays them for the tiles (and the replay recording)
+    UMatch3BoardHost* Host = bUseBoardHost ? GetWorld()->GetSubsystem<UMatch3BoardHost>() : nullptr;
+    if (Host)
+    {
+        HostHandle = Host->CreateBoard(Rows, Cols, BoardSeed, Board.Scoring.Rules, bShuffleDeadBoards, Board.Shape, Board.NumColors,
+            MaxCascadeDepth);
+        HostTurnDelegate = Host->OnTurnResolved.AddUObject(this, &AMatch3Grid::OnHostTurn);
+
+        TArray<uint8> Snapshot;
+        Host->WriteSnapshot(HostHandle, Snapshot);
+        bInputLocked = true;
+        SendTurnToClients(1, INDEX_NONE, Snapshot);
+        QueueAuthoritativeTurn(1, INDEX_NONE, MoveTemp(Snapshot));
+        return;
+    }
+
+    // same on a thread of our own, its first event is the board
+    if (bUseSimThread)
+    {
+        SimThread = MakeUnique<FMatch3SimThread>(Board);
+        bInputLocked = true;
+        SetActorTickEnabled(true);
+        return;
+    }
+
     RegenerateGrid();
+    SendTurnToClients(INDEX_NONE);
+}
+
+
+void AMatch3Grid::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+    if (UMatch3BoardHost* Host = HostHandle.IsValid() ? GetWorld()->GetSubsystem<UMatch3BoardHost>() : nullptr)
+    {
+        Host->OnTurnResolved.Remove(HostTurnDelegate);
+        Host->DestroyBoard(HostHandle);
+    }
+    HostHandle = FMatch3BoardHandle();
+    SimThread.Reset();
+    SimEvents.Reset();
+    Cascade.Reset();
+    Ai.Reset();
+
+    // joins the writer thread after it wrote the rest of the ring
+    Telemetry.Reset();
+
+    Super::EndPlay(EndPlayReason);
 }
 
 
 void AMatch3Grid::RegenerateGrid()
 {
+    // a running cascade belongs to the old board
+    Cascade.Reset();
+    PendingGroups.Reset();
+
     // destroy any existing tiles
     DestroyAllTiles();
 
-    // try generating until the rules are satisfied
-    // - no initial 3+ matches
-    // - at least one possible move
-    // simple loop with safety limit
-    const int32 MaxAttempts = 50;
-    int32 Attempt = 0;
+    // generate on the board (no initial matches, at least one possible move)
+    // then spawn tiles for it; a pooled board was made ahead on a worker thread
+    // (pools make rectangles, shaped levels generate here)
+    FMatch3BoardPool* Pool = nullptr;
+    if (bUseBoardPool && !IsFollower() && !Board.Shape)
+    {
+        if (UMatch3BoardPoolSubsystem* Pools = GetGameInstance() ? GetGameInstance()->GetSubsystem<UMatch3BoardPoolSubsystem>() : nullptr)
+        {
+            Pool = Pools->GetPool(Rows, Cols, Board.NumColors);
+        }
+    }
 
-    do
+    if (Pool)
     {
-        DestroyAllTiles();
-        FillGridRandomly();
-        Attempt++;
-        if (Attempt >= MaxAttempts)
+        int32 RegenSeed = 0;
+        if (!Pool->TryPop(Board, RegenSeed))
         {
-            UE_LOG(LogTemp, Warning, TEXT("RegenerateGrid: Max attempts reached; accepting current grid."));
-            break;
+            Pool->Regenerate(Board, RegenSeed);
         }
-    } while (HasAnyMatches() || !HasPossibleMove());
+        if (bRecordReplay)
+        {
+            Replay.RecordReseed(RegenSeed);
+        }
+        RecordTelemetry(EMatch3TelemetryEvent::Regenerate, RegenSeed);
+    }
+    else
+    {
+        // followers get the owner's board right after, any board will do
+        Board.Regenerate();
+        RecordTelemetry(EMatch3TelemetryEvent::Regenerate);
+    }
+    SpawnAllTiles();
 
-    Score = 0;
     bInputLocked = false;
 }
 
 
-// make sure that there are no matches
-void AMatch3Grid::FillGridRandomly()
+bool AMatch3Grid::ShuffleGrid()
+{
+    if (!Board.bShuffleDeadBoards || !Board.Shuffle(&ShuffleSource)) return false;
+    RecordTelemetry(EMatch3TelemetryEvent::Shuffle);
+    MoveShuffledTiles(ShuffleSource);
+
+    bInputLocked = false;
+    return true;
+}
+
+
+void AMatch3Grid::MoveShuffledTiles(TConstArrayView<int32> Source)
+{
+    // move the existing tiles to their new cells, nothing is destroyed or spawned
+    ShuffleTiles = GridArray;
+    for (int32 i = 0; i < GridArray.Num(); ++i)
+    {
+        AMatchTile* Tile = ShuffleTiles[Source[i]];
+        GridArray[i] = Tile;
+        if (Tile && Source[i] != i)
+        {
+            Tile->SetGridPosition(i / Cols, i % Cols, CellSize, GridOrigin);
+        }
+    }
+}
+
+
+bool AMatch3Grid::SaveReplay(const FString& Filename)
+{
+    if (bInputLocked)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("SaveReplay: board is resolving; try again after the turn."));
+        return false;
+    }
+
+    Replay.Finish(Board);
+    return Replay.SaveToFile(Filename);
+}
+
+
+bool AMatch3Grid::SaveSnapshot(const FString& Filename, bool bAppend)
+{
+    if (PendingGroups.MatchedCells.Num() > 0)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("SaveSnapshot: board is resolving; try again after the turn."));
+        return false;
+    }
+
+    return FMatch3Snapshot::SaveToFile(Board, bInputLocked, Filename, bAppend);
+}
+
+
+bool AMatch3Grid::LoadSnapshot(const FString& Filename, int32 Index)
+{
+    FMatch3MappedSnapshots Snapshots;
+    bool bLocked = false;
+    if (!Snapshots.Open(Filename) || !Snapshots.Restore(Index, Board, bLocked))
+    {
+        UE_LOG(LogTemp, Warning, TEXT("LoadSnapshot: could not restore %s [%d]"), *Filename, Index);
+        return false;
+    }
+
+    Cascade.Reset();
+    PendingGroups.Reset();
+    QueuedSwaps.Reset();
+
+    Rows = Board.Rows;
+    Cols = Board.Cols;
+    NumColors = Board.NumColors;
+    PendingGroups.Reserve(Rows * Cols);
+    Score = Board.Score;
+    bInputLocked = bLocked;
+
+    DestroyAllTiles();
+    SpawnAllTiles();
+
+    // the recording starts from a seed, it cannot continue from a restored board
+    if (bRecordReplay)
+    {
+        UE_LOG(LogTemp, Log, TEXT("LoadSnapshot: replay recording stopped."));
+        bRecordReplay = false;
+    }
+
+    SendTurnToClients(INDEX_NONE);
+    return true;
+}
+
+
+void AMatch3Grid::SpawnAllTiles()
 {
     GridArray.Init(nullptr, Rows * Cols);
 
@@ -59,33 +282,8 @@ void AMatch3Grid::FillGridRandomly()
     {
         for (int c = 0; c < Cols; ++c)
         {
-            ETileColor Color;
-
-            while (true)
-            {
-                Color = static_cast<ETileColor>(FMath::RandRange(0, 3));
-
-                // Check horizontal
-                bool badHorizontal =
-                    c >= 2 &&
-                    GetTileAt(r, c - 1) &&
-                    GetTileAt(r, c - 2) &&
-                    GetTileAt(r, c - 1)->Color == Color &&
-                    GetTileAt(r, c - 2)->Color == Color;
-
-                // Check vertical
-                bool badVertical =
-                    r >= 2 &&
-                    GetTileAt(r - 1, c) &&
-                    GetTileAt(r - 2, c) &&
-                    GetTileAt(r - 1, c)->Color == Color &&
-                    GetTileAt(r - 2, c)->Color == Color;
-
-                if (!badHorizontal && !badVertical)
-                    break;
-            }
-
-            SpawnTileAt(r, c, Color);
+            if (Board.GetCell(r, c) == FMatch3Board::NoCell) continue;
+            SpawnTileAt(r, c, static_cast<ETileColor>(Board.GetCell(r, c)));
         }
     }
 }
@@ -98,6 +296,7 @@ void AMatch3Grid::SpawnTileAt(int32 Row, int32 Col, ETileColor Color)
 
     FActorSpawnParameters Params;
     Params.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+    Params.Owner = this;
 
     FVector Loc = AMatchTile::GetWorldLocationForGrid(Row, Col, CellSize, GridOrigin);
     AMatchTile* Tile = GetWorld()->SpawnActor<AMatchTile>(TileClass, Loc, FRotator::ZeroRotator, Params);
@@ -123,358 +322,615 @@ bool AMatch3Grid::IsInside(int32 Row, int32 Col) const
 }
 
 
-// find all matches (3+ horizontal or vertical) and return unique tile list
-TArray<AMatchTile*> AMatch3Grid::FindAllMatches() const
+// try swapping two tiles, actual swap only kept if it results in at least one match
+void AMatch3Grid::AttemptSwap(AMatchTile* A, AMatchTile* B)
+{
+    if (!A || !B) return;
+
+    RequestSwap(Index(A->Row, A->Col), Index(B->Row, B->Col));
+}
+
+
+void AMatch3Grid::RequestSwap(int32 CellA, int32 CellB)
 {
-    TArray<AMatchTile*> Matches;
-    Matches.Reserve(Rows * Cols / 4);
+    // ensure A and B are adjacent
+    if (!Board.AreAdjacent(CellA, CellB)) return;
 
-    // Horizontal
-    for (int r = 0; r < Rows; ++r)
+    // the host checks it in its next update, OnHostTurn reports back
+    if (HostHandle.IsValid())
     {
-        for (int c = 0; c <= Cols - 3; ++c)
+        if (UMatch3BoardHost* Host = GetWorld()->GetSubsystem<UMatch3BoardHost>())
         {
-            AMatchTile* A = GetTileAt(r, c);
-            AMatchTile* B = GetTileAt(r, c + 1);
-            AMatchTile* C = GetTileAt(r, c + 2);
-            if (!A || !B || !C) continue;
-            if (A->Color == B->Color && B->Color == C->Color)
-            {
-                // extend run
-                int runEnd = c + 2;
-                while (runEnd + 1 < Cols && GetTileAt(r, runEnd + 1) && GetTileAt(r, runEnd + 1)->Color == A->Color)
-                {
-                    runEnd++;
-                }
-                for (int k = c; k <= runEnd; ++k)
-                {
-                    Matches.AddUnique(GetTileAt(r, k));
-                }
-                c = runEnd;
-            }
+            Host->QueueSwap(HostHandle, CellA, CellB);
         }
+        return;
     }
 
-    // Vertical
-    for (int c = 0; c < Cols; ++c)
+    // a full command ring drops the swap, like a full queue below
+    if (SimThread)
     {
-        for (int r = 0; r <= Rows - 3; ++r)
-        {
-            AMatchTile* A = GetTileAt(r, c);
-            AMatchTile* B = GetTileAt(r + 1, c);
-            AMatchTile* C = GetTileAt(r + 2, c);
-            if (!A || !B || !C) continue;
-            if (A->Color == B->Color && B->Color == C->Color)
-            {
-                int runEnd = r + 2;
-                while (runEnd + 1 < Rows && GetTileAt(runEnd + 1, c) && GetTileAt(runEnd + 1, c)->Color == A->Color)
-                {
-                    runEnd++;
-                }
-                for (int k = r; k <= runEnd; ++k)
-                {
-                    Matches.AddUnique(GetTileAt(k, c));
-                }
-                r = runEnd;
-            }
-        }
+        SimThread->PushSwap(CellA, CellB);
+        return;
     }
 
-    return Matches;
-}
+    if (!bInputLocked)
+    {
+        const bool bAccepted = StartSwap(CellA, CellB, MaxQueuedSwaps > 0);
+        RecordTelemetry(bAccepted ? EMatch3TelemetryEvent::SwapAccepted : EMatch3TelemetryEvent::SwapRejected, CellA, CellB);
+        OnSwapChecked.Broadcast(CellA, CellB, bAccepted);
+        return;
+    }
 
+    // mid cascade: check it now against the board the running turn will leave,
+    // so the player gets feedback without waiting for the clears
+    if (QueuedSwaps.Num() >= MaxQueuedSwaps) return;
 
-bool AMatch3Grid::HasAnyMatches() const
-{
-    TArray<AMatchTile*> Found = FindAllMatches();
-    return Found.Num() > 0;
+    // a dead board is replaced when the turn ends, nothing to check against
+    const bool bAccepted = !bPredictedRegenerate && PredictedBoard.TrySwap(CellA, CellB);
+    if (bAccepted)
+    {
+        int32 Depth = 0;
+        bPredictedRegenerate = PredictedBoard.ResolveCascade(Depth) && !PredictedBoard.TryShuffleDeadBoard();
+        QueuedSwaps.Add(FIntPoint(CellA, CellB));
+    }
+    RecordTelemetry(bAccepted ? EMatch3TelemetryEvent::SwapAccepted : EMatch3TelemetryEvent::SwapRejected, CellA, CellB);
+    OnSwapChecked.Broadcast(CellA, CellB, bAccepted);
 }
 
 
-// try swapping two tiles, actual swap only kept if it results in at least one match
-void AMatch3Grid::AttemptSwap(AMatchTile* A, AMatchTile* B)
+bool AMatch3Grid::StartSwap(int32 CellA, int32 CellB, bool bPredict)
 {
-    if (!A || !B) return;
-    if (bInputLocked) return;
+    if (bRecordReplay)
+    {
+        Replay.RecordSwap(CellA, CellB);
+    }
 
-    // ensure A and B are adjacent
-    int dR = FMath::Abs(A->Row - B->Row);
-    int dC = FMath::Abs(A->Col - B->Col);
-    if ((dR + dC) != 1) return;
-
-    // swap in array
-    int rA = A->Row, cA = A->Col;
-    int rB = B->Row, cB = B->Col;
-
-    GridArray[Index(rA, cA)] = B;
-    GridArray[Index(rB, cB)] = A;
-
-    // update positions immediately (no anim)
-    A->SetGridPosition(rB, cB, CellSize, GridOrigin);
-    B->SetGridPosition(rA, cA, CellSize, GridOrigin);
-
-    // check for matches
-    TArray<AMatchTile*> Matches = FindAllMatches();
-    if (Matches.Num() == 0)
-    {
-        // swap back
-        GridArray[Index(rA, cA)] = A;
-        GridArray[Index(rB, cB)] = B;
-        A->SetGridPosition(rA, cA, CellSize, GridOrigin);
-        B->SetGridPosition(rB, cB, CellSize, GridOrigin);
-        return;
+    // swap on the board, it swaps back if there is no match
+    if (!Board.TrySwap(CellA, CellB)) return false;
+
+    const int32 First = FMath::Min(CellA, CellB);
+    CurrentSwap = (First << 1) | (FMath::Abs(CellA - CellB) != 1 ? 1 : 0);
+    SwapTiles(CellA, CellB);
+
+    // resolve the whole turn ahead of the timers for swaps queued meanwhile
+    if (bPredict)
+    {
+        int32 Depth = 0;
+        PredictedBoard.CopyFrom(Board);
+        bPredictedRegenerate = PredictedBoard.ResolveCascade(Depth) && !PredictedBoard.TryShuffleDeadBoard();
     }
 
     // have matches => resolve them
+    Board.BeginCascade(PendingGroups);
+    CascadeDepth = 0;
+
     bInputLocked = true;
-    StartClear(Matches);
+    LockStartCycles = FPlatformTime::Cycles64();
+    Cascade = RunCascade();
+    return true;
+}
+
+
+float AMatch3Grid::GetClearDelay() const
+{
+    return FApp::CanEverRender() ? ClearDelay : 0.f;
 }
 
 
-void AMatch3Grid::StartClear(const TArray<AMatchTile*>& Matches)
+FMatch3Routine AMatch3Grid::RunCascade()
 {
-    if (Matches.Num() == 0)
+    const float Delay = GetClearDelay();
+    while (PendingGroups.MatchedCells.Num() > 0)
     {
-        bInputLocked = false;
-        return;
+        // let the player see the match before it clears
+        co_await Match3Delay(this, Delay);
+
+        // stop after the last step, the groups of a chain reaction are already pending
+        if (!ClearPendingGroups()) break;
     }
 
-    bInputLocked = true;
-    PendingClearMatches = Matches;
+    FinishTurn();
+}
 
-    // Delay before the clear happens
-    GetWorld()->GetTimerManager().SetTimer(
-        ClearTimerHandle,
-        this,
-        &AMatch3Grid::PerformClear,
-        ClearDelay,
-        false
-    );
+
+// resolve the whole cascade without delays
+void AMatch3Grid::ClearMatches()
+{
+    while (ClearPendingGroups())
+    {
+    }
+
+    FinishTurn();
 }
 
 
-void AMatch3Grid::PerformClear()
+bool AMatch3Grid::ClearPendingGroups()
 {
-    if (PendingClearMatches.Num() == 0)
+    if (PendingGroups.MatchedCells.Num() == 0) return false;
+    const uint64 StepStartCycles = FPlatformTime::Cycles64();
+    RemoveTiles(PendingGroups.MatchedCells);
+
+    // score, clear, gravity and refill on the board, then rescan the changed cells
+    const int32 NumCleared = PendingGroups.MatchedCells.Num();
+    const bool bMore = Board.StepCascade(PendingGroups, CascadeDepth);
+    RecordTelemetry(EMatch3TelemetryEvent::CascadeStep, NumCleared, CascadeDepth);
+    DropAndSpawnTiles();
+
+    const double StepSeconds = FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StepStartCycles);
+    RecordTelemetry(EMatch3TelemetryEvent::ResolveFrame, static_cast<int32>(StepSeconds * 1e6));
+    return bMore;
+}
+
+
+void AMatch3Grid::FinishTurn()
+{
+    bInputLocked = false;
+
+    const bool bRegenerate = Board.EndCascade(PendingGroups, CascadeDepth);
+    PendingGroups.Reset();
+
+    ReportTurn(Board.Scoring.Turn.CellsCleared, Board.Scoring.Turn.Points);
+
+    // No moves (or cascade cap)? Shuffle or regenerate grid
+    if (bRegenerate && !ShuffleGrid())
     {
-        bInputLocked = false;
+        RegenerateGrid();
+    }
+
+    // followers replayed the owner's swap, keep them in step with its result
+    if (IsFollower())
+    {
+        CheckNetBoard();
+        PlayNetTurns();
         return;
     }
 
-    // Destroy tiles
-    for (AMatchTile* Tile : PendingClearMatches)
+    SendTurnToClients(CurrentSwap);
+    CurrentSwap = INDEX_NONE;
+
+    // start the next queued swap right away, PredictedBoard already includes it
+    if (QueuedSwaps.Num() > 0)
     {
-        if (!Tile) continue;
-        int r = Tile->Row;
-        int c = Tile->Col;
-        GridArray[Index(r, c)] = nullptr;
-        Tile->Destroy();
+        const FIntPoint Next = QueuedSwaps[0];
+        QueuedSwaps.RemoveAt(0, 1, EAllowShrinking::No);
+        if (!StartSwap(Next.X, Next.Y, false))
+        {
+            UE_LOG(LogTemp, Warning, TEXT("Queued swap %d-%d no longer matches; dropping the queue."), Next.X, Next.Y);
+            QueuedSwaps.Reset();
+        }
     }
+}
 
-    PendingClearMatches.Empty();
 
-    // Apply gravity and refill
-    ApplyGravityAndRefill();
+void AMatch3Grid::ReportTurn(int32 CellsCleared, int32 TurnPoints)
+{
+    Score = Board.Score;
 
-    // Check for cascades after gravity
-    TArray<AMatchTile*> NewMatches = FindAllMatches();
+    if (Telemetry)
+    {
+        Telemetry->Record(EMatch3TelemetryEvent::TurnEnd, CellsCleared, CascadeDepth);
+        if (LockStartCycles != 0)
+        {
+            const double LockedSeconds = FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - LockStartCycles);
+            Telemetry->Record(EMatch3TelemetryEvent::Locked, static_cast<int32>(LockedSeconds * 1e6));
+        }
+    }
+    LockStartCycles = 0;
+    if (TurnPoints > 0)
+    {
+        OnScoreChanged.Broadcast(Score, TurnPoints);
+    }
 
-    if (NewMatches.Num() > 0)
+    // win check
+    if (!bHasWon && Score >= WinScore)
     {
-        StartClear(NewMatches); // chain reaction with delay
-        return;
+        bHasWon = true;
+        UE_LOG(LogTemp, Log, TEXT("YOU WIN! Score=%d"), Score);
+        // UI HERE
     }
+}
 
-    bInputLocked = false;
 
-    // No moves? Regenerate grid
-    if (!HasPossibleMove())
+void AMatch3Grid::SendTurnToClients(int32 Swap)
+{
+    const ENetMode NetMode = GetNetMode();
+    if (NetMode == NM_Standalone || NetMode == NM_Client) return;
+
+    const int32 Sequence = ++NetSequence;
+    TArray<uint8>& Snapshot = NetHistory[Sequence % NetHistorySize];
+    Snapshot.SetNumZeroed(FMatch3Snapshot::GetRecordSize(Rows, Cols, Board.NumColors));
+    FMatch3Snapshot::Write(Board, false, Snapshot);
+    SendNetHistory(Sequence, Swap);
+}
+
+
+void AMatch3Grid::SendTurnToClients(int32 Sequence, int32 Swap, TConstArrayView<uint8> Snapshot)
+{
+    const ENetMode NetMode = GetNetMode();
+    if (NetMode == NM_Standalone || NetMode == NM_Client) return;
+
+    TArray<uint8>& Slot = NetHistory[Sequence % NetHistorySize];
+    Slot.Reset();
+    Slot.Append(Snapshot.GetData(), Snapshot.Num());
+    SendNetHistory(Sequence, Swap);
+}
+
+
+void AMatch3Grid::SendNetHistory(int32 Sequence, int32 Swap)
+{
+    const TArray<uint8>& Snapshot = NetHistory[Sequence % NetHistorySize];
+    NetHistorySequence[Sequence % NetHistorySize] = Sequence;
+
+    for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
     {
-        RegenerateGrid();
+        AMatch3PlayerController* Controller = Cast<AMatch3PlayerController>(It->Get());
+        if (!Controller || Controller->IsLocalController()) continue;
+
+        // delta against the newest board this client acked, full if it fell out of history
+        const int32 Acked = Controller->GetAckedSequence();
+        const bool bHasBase = Acked != INDEX_NONE && NetHistorySequence[Acked % NetHistorySize] == Acked;
+
+        FMatch3NetTurn Turn;
+        Turn.Sequence = Sequence;
+        Turn.BaseSequence = bHasBase ? Acked : INDEX_NONE;
+        Turn.Swap = Swap;
+        Match3NetDelta::Encode(bHasBase ? TConstArrayView<uint8>(NetHistory[Acked % NetHistorySize]) : TConstArrayView<uint8>(), Snapshot, Turn.Delta);
+        Controller->ClientReceiveTurn(Turn);
     }
 }
 
 
-void AMatch3Grid::ClearMatches(const TArray<AMatchTile*>& Matches)
+void AMatch3Grid::SendBoardTo(AMatch3PlayerController* Controller)
+{
+    const int32 Slot = NetSequence % NetHistorySize;
+    if (!Controller || NetSequence == 0 || NetHistorySequence[Slot] != NetSequence) return;
+
+    FMatch3NetTurn Turn;
+    Turn.Sequence = NetSequence;
+    Match3NetDelta::Encode(TConstArrayView<uint8>(), NetHistory[Slot], Turn.Delta);
+    Controller->ClientReceiveTurn(Turn);
+}
+
+
+bool AMatch3Grid::ReceiveNetTurn(const FMatch3NetTurn& Turn)
 {
-    if (Matches.Num() == 0)
+    TConstArrayView<uint8> Base;
+    if (Turn.BaseSequence != INDEX_NONE)
     {
-        bInputLocked = false;
-        return;
+        const int32 BaseSlot = Turn.BaseSequence % NetHistorySize;
+        if (NetHistorySequence[BaseSlot] != Turn.BaseSequence) return false;
+        Base = NetHistory[BaseSlot];
     }
 
-    // scoring: award 100 points per clear, count one clear per tile-grouping:
-    int32 Award = PointsPerClear * FMath::Max(1, Matches.Num() / 3);
-    Score += Award;
-    UE_LOG(LogTemp, Log, TEXT("Cleared %d tiles. Score=%d"), Matches.Num(), Score);
+    TArray<uint8> Snapshot;
+    if (!Match3NetDelta::Decode(Base, Turn.Delta, Snapshot)) return false;
+
+    const int32 Slot = Turn.Sequence % NetHistorySize;
+    NetHistory[Slot] = Snapshot;
+    NetHistorySequence[Slot] = Turn.Sequence;
+
+    QueueAuthoritativeTurn(Turn.Sequence, Turn.Swap, MoveTemp(Snapshot));
+    return true;
+}
 
-    // remove tiles
-    for (AMatchTile* Tile : Matches)
+
+void AMatch3Grid::QueueAuthoritativeTurn(int32 Sequence, int32 Swap, TArray<uint8>&& Snapshot)
+{
+    // the delta field carries the decoded board while queued
+    FMatch3NetTurn& Pending = PendingNetTurns.AddDefaulted_GetRef();
+    Pending.Sequence = Sequence;
+    Pending.Swap = Swap;
+    Pending.Delta = MoveTemp(Snapshot);
+
+    // before BeginPlay, Board.Init would wipe whatever we play now
+    if (!bBoardReady) return;
+    PlayNetTurns();
+}
+
+
+void AMatch3Grid::OnHostTurn(FMatch3BoardHandle Handle, int32 Sequence, int32 Swap, bool bAccepted)
+{
+    if (Handle != HostHandle) return;
+
+    NotifySwapChecked(Swap, bAccepted);
+    if (!bAccepted) return;
+
+    UMatch3BoardHost* Host = GetWorld()->GetSubsystem<UMatch3BoardHost>();
+    TArray<uint8> Snapshot;
+    if (Host && Host->WriteSnapshot(HostHandle, Snapshot))
     {
-        if (!Tile) continue;
-        int r = Tile->Row;
-        int c = Tile->Col;
-        GridArray[Index(r, c)] = nullptr;
-        Tile->Destroy();
+        // clients get the host's board under the host's sequence, our tiles catch up later
+        SendTurnToClients(Sequence, Swap, Snapshot);
+        QueueAuthoritativeTurn(Sequence, Swap, MoveTemp(Snapshot));
     }
+}
 
-    // gravity and refill
-    ApplyGravityAndRefill();
 
-    // chains: find new matches and recursively clear
-    TArray<AMatchTile*> NewMatches = FindAllMatches();
-    if (NewMatches.Num() > 0)
+void AMatch3Grid::Tick(float DeltaSeconds)
+{
+    Super::Tick(DeltaSeconds);
+
+    // the simulation thread's events: swap feedback right away, the rest is animated
+    while (SimThread && SimThread->PopEvent(SimEvent))
     {
-        ClearMatches(NewMatches);
+        if (SimEvent.Type == EMatch3SimEventType::Swap)
+        {
+            NotifySwapChecked(SimEvent.Swap, SimEvent.bAccepted);
+            if (!SimEvent.bAccepted) continue;
+        }
+        SimEvents.Add(MoveTemp(SimEvent));
     }
-    else
+    if (SimEvents.Num() > 0 && !Cascade.IsActive())
     {
-        bInputLocked = false;
+        Cascade = PlaySimEvents();
+    }
 
-        // after resolution, if no possible moves, regenerate
-        if (!HasPossibleMove())
+    // the AI thinks between turns; only its decision reaches the game thread
+    if (Ai)
+    {
+        int32 CellA = 0;
+        int32 CellB = 0;
+        if (Ai->TryGetDecision(CellA, CellB))
+        {
+            RequestSwap(CellA, CellB);
+        }
+        else if (!Ai->IsSearching() && !bInputLocked && PendingNetTurns.Num() == 0 && SimEvents.Num() == 0)
         {
-            UE_LOG(LogTemp, Log, TEXT("No possible moves  regenerating grid"));
-            RegenerateGrid();
-            return;
+            Ai->StartSearch(Board);
         }
+    }
+}
 
-        // win check
-        if (Score >= WinScore)
+
+void AMatch3Grid::NotifySwapChecked(int32 Swap, bool bAccepted)
+{
+    const int32 CellA = Swap >> 1;
+    const int32 CellB = CellA + ((Swap & 1) ? Cols : 1);
+    RecordTelemetry(bAccepted ? EMatch3TelemetryEvent::SwapAccepted : EMatch3TelemetryEvent::SwapRejected, CellA, CellB);
+    OnSwapChecked.Broadcast(CellA, CellB, bAccepted);
+}
+
+
+FMatch3Routine AMatch3Grid::PlaySimEvents()
+{
+    const float Delay = GetClearDelay();
+    while (SimEvents.Num() > 0)
+    {
+        const FMatch3SimEvent Event = MoveTemp(SimEvents[0]);
+        SimEvents.RemoveAt(0, 1, EAllowShrinking::No);
+
+        // let the player see the match before it clears, like RunCascade
+        if (Event.Type == EMatch3SimEventType::Step)
         {
-            UE_LOG(LogTemp, Log, TEXT("YOU WIN! Score=%d"), Score);
-            // UI HERE
+            co_await Match3Delay(this, Delay);
         }
+        ShowSimEvent(Event);
     }
 }
 
 
-void AMatch3Grid::ApplyGravityAndRefill()
+void AMatch3Grid::ShowSimEvent(const FMatch3SimEvent& Event)
 {
-    // shift tiles down column by column
-    for (int c = 0; c < Cols; ++c)
+    switch (Event.Type)
     {
-        int writeRow = Rows - 1;
-        for (int r = Rows - 1; r >= 0; --r)
+    case EMatch3SimEventType::Board:
+        if (!ShowBoard(Event.Snapshot))
         {
-            AMatchTile* Tile = GetTileAt(r, c);
-            if (Tile)
-            {
-                if (writeRow != r)
-                {
-                    GridArray[Index(writeRow, c)] = Tile;
-                    Tile->SetGridPosition(writeRow, c, CellSize, GridOrigin);
-                    GridArray[Index(r, c)] = nullptr;
-                }
-                writeRow--;
-            }
+            UE_LOG(LogTemp, Warning, TEXT("Sim: bad board for turn %d"), Event.Sequence);
         }
+        break;
 
-        // fill remaining above
-        for (int r = writeRow; r >= 0; --r)
+    case EMatch3SimEventType::Swap:
+    {
+        const int32 CellA = Event.Swap >> 1;
+        const int32 CellB = CellA + ((Event.Swap & 1) ? Cols : 1);
+        if (bRecordReplay)
+        {
+            Replay.RecordSwap(CellA, CellB);
+        }
+        Board.SwapCells(CellA, CellB);
+        SwapTiles(CellA, CellB);
+        CurrentSwap = Event.Swap;
+        CascadeDepth = 0;
+        bInputLocked = true;
+        LockStartCycles = FPlatformTime::Cycles64();
+        break;
+    }
+
+    case EMatch3SimEventType::Step:
+    {
+        // Board only mirrors the thread's colors, so the refills spawn in the right color
+        const uint64 StepStartCycles = FPlatformTime::Cycles64();
+        RemoveTiles(Event.ClearedCells);
+        for (int32 i = 0; i < Event.ChangedCells.Num(); ++i)
         {
-            ETileColor Color = static_cast<ETileColor>(FMath::RandRange(0, 3));
-            SpawnTileAt(r, c, Color);
+            Board.SetCell(Event.ChangedCells[i], Event.ChangedColors[i]);
         }
+        DropAndSpawnTiles();
+        CascadeDepth = Event.Depth;
+        RecordTelemetry(EMatch3TelemetryEvent::CascadeStep, Event.ClearedCells.Num(), CascadeDepth);
+
+        const double StepSeconds = FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StepStartCycles);
+        RecordTelemetry(EMatch3TelemetryEvent::ResolveFrame, static_cast<int32>(StepSeconds * 1e6));
+        break;
+    }
+
+    case EMatch3SimEventType::TurnEnd:
+        Board.Score = Event.Score;
+        CascadeDepth = Event.Depth;
+        ReportTurn(Event.CellsCleared, Event.Points);
+        bInputLocked = false;
+        break;
+
+    case EMatch3SimEventType::Shuffle:
+        FMemory::Memcpy(Board.Cells.GetData(), Event.ChangedColors.GetData(), Board.Num());
+        Board.CellsChanged();
+        RecordTelemetry(EMatch3TelemetryEvent::Shuffle);
+        MoveShuffledTiles(Event.ChangedCells);
+        break;
+    }
+
+    // the turn is settled: clients replay its swap from the last board we sent them
+    if (Event.Snapshot.Num() > 0)
+    {
+        SendTurnToClients(++NetSequence, CurrentSwap, Event.Snapshot);
+        CurrentSwap = INDEX_NONE;
     }
 }
 
 
-// detect if any single adjacent swap would create a match
-bool AMatch3Grid::HasPossibleMove() const
+void AMatch3Grid::PlayNetTurns()
 {
-    // for each pair of adjacent tiles, simulate swap and test for any matches
-    auto SimSwapCreatesMatch = [&](int r1, int c1, int r2, int c2) -> bool
+    while (PendingNetTurns.Num() > 0)
+    {
+        // a turn is still animating, its FinishTurn comes back here
+        if (PendingGroups.MatchedCells.Num() > 0) return;
+
+        FMatch3NetTurn Turn = MoveTemp(PendingNetTurns[0]);
+        PendingNetTurns.RemoveAt(0);
+
+        const bool bNext = Turn.Sequence == NetSequence + 1 && NetSequence > 0;
+        NetSequence = Turn.Sequence;
+        NetAuthoritative = MoveTemp(Turn.Delta);
+
+        // the board carries the server's stream state, so the swap resolves the same way
+        // here and the tiles animate with the usual timers; FinishTurn checks the result
+        if (bNext && Turn.Swap != INDEX_NONE)
         {
-            if (!IsInside(r1, c1) || !IsInside(r2, c2)) return false;
-            AMatchTile* T1 = GetTileAt(r1, c1);
-            AMatchTile* T2 = GetTileAt(r2, c2);
-            if (!T1 || !T2) return false;
+            const int32 CellA = Turn.Swap >> 1;
+            const int32 CellB = CellA + ((Turn.Swap & 1) ? Cols : 1);
+            if (StartSwap(CellA, CellB, false)) return;
+        }
 
-            // swap colors only (fast)
-            ETileColor Col1 = T1->Color;
-            ETileColor Col2 = T2->Color;
+        CheckNetBoard();
+    }
+}
 
-            // perform color swap in temp and check nearby matches
-            auto CheckMatchAt = [&](int r, int c) -> bool
-                {
-                    // horizontal
-                    int count = 1;
-                    // left
-                    for (int cc = c - 1; cc >= 0; --cc)
-                    {
-                        AMatchTile* S = (r == r1 && cc == c1) ? ((r2 == r1 && cc == c2) ? nullptr : GetTileAt(r, cc)) : GetTileAt(r, cc);
-                    }
 
-                    auto GetColorWithSwap = [&](int rr, int cc)->ETileColor
-                        {
-                            if (rr == r1 && cc == c1) return Col2;
-                            if (rr == r2 && cc == c2) return Col1;
-                            AMatchTile* T = GetTileAt(rr, cc);
-                            return T ? T->Color : ETileColor::Red; // default
-                        };
-
-                    // horizontal count
-                    ETileColor center = GetColorWithSwap(r, c);
-                    if (center == ETileColor::Red && !GetTileAt(r, c)) return false;
-                    int left = 0;
-                    for (int cc = c - 1; cc >= 0; --cc) {
-                        if (GetColorWithSwap(r, cc) == center) left++; else break;
-                    }
-                    int right = 0;
-                    for (int cc = c + 1; cc < Cols; ++cc) {
-                        if (GetColorWithSwap(r, cc) == center) right++; else break;
-                    }
-                    if (left + 1 + right >= 3) return true;
+void AMatch3Grid::CheckNetBoard()
+{
+    NetScratch.SetNumZeroed(NetAuthoritative.Num());
+    if (Board.Num() > 0 && FMatch3Snapshot::Write(Board, false, NetScratch) && NetScratch == NetAuthoritative)
+    {
+        bInputLocked = false;
+        return;
+    }
+
+    if (!ShowBoard(NetAuthoritative))
+    {
+        UE_LOG(LogTemp, Warning, TEXT("Net: bad board for turn %d"), NetSequence);
+        return;
+    }
+    Cascade.Reset();
+}
+
+
+bool AMatch3Grid::ShowBoard(TConstArrayView<uint8> Snapshot)
+{
+    bool bLocked = false;
+    if (!FMatch3Snapshot::Read(Snapshot, Board, bLocked)) return false;
+
+    PendingGroups.Reset();
+    Rows = Board.Rows;
+    Cols = Board.Cols;
+    NumColors = Board.NumColors;
+    PendingGroups.Reserve(Rows * Cols);
+    Score = Board.Score;
+
+    DestroyAllTiles();
+    SpawnAllTiles();
+    bInputLocked = false;
+    return true;
+}
+
+
+void AMatch3Grid::SwapTiles(int32 CellA, int32 CellB)
+{
+    // keep the swap: update array and positions (no anim)
+    AMatchTile* A = GridArray[CellA];
+    AMatchTile* B = GridArray[CellB];
+    GridArray[CellA] = B;
+    GridArray[CellB] = A;
+
+    if (A) A->SetGridPosition(CellB / Cols, CellB % Cols, CellSize, GridOrigin);
+    if (B) B->SetGridPosition(CellA / Cols, CellA % Cols, CellSize, GridOrigin);
+}
 
-                    // vertical
-                    int up = 0;
-                    for (int rr = r - 1; rr >= 0; --rr) {
-                        if (GetColorWithSwap(rr, c) == center) up++; else break;
-                    }
-                    int down = 0;
-                    for (int rr = r + 1; rr < Rows; ++rr) {
-                        if (GetColorWithSwap(rr, c) == center) down++; else break;
-                    }
-                    if (up + 1 + down >= 3) return true;
 
-                    return false;
-                };
+void AMatch3Grid::RemoveTiles(TConstArrayView<int32> InCells)
+{
+    for (int32 Cell : InCells)
+    {
+        if (AMatchTile* Tile = GridArray[Cell])
+        {
+            Tile->Destroy();
+        }
+        GridArray[Cell] = nullptr;
+    }
+}
 
-            // check tiles near both positions
-            for (int dr = -2; dr <= 2; ++dr)
+
+void AMatch3Grid::DropAndSpawnTiles()
+{
+    // same compaction as the board's gravity, so tiles land where their colors did
+    if (const FMatch3BoardShape* Shape = Board.Shape.Get())
+    {
+        // along the shape's fall segments, around holes and blocked cells
+        for (const FMatch3BoardShape::FSegment& Segment : Shape->Segments)
+        {
+            const int32* SegmentRows = Shape->FallRows.GetData() + Segment.First;
+            const int32 c = Segment.Col;
+            int32 Write = 0;
+            for (int32 i = 0; i < Segment.Num; ++i)
             {
-                for (int dc = -2; dc <= 2; ++dc)
+                AMatchTile* Tile = GridArray[Index(SegmentRows[i], c)];
+                if (Tile)
                 {
-                    int rr = r1 + dr;
-                    int cc = c1 + dc;
-                    if (IsInside(rr, cc) && CheckMatchAt(rr, cc)) return true;
-                    rr = r2 + dr;
-                    cc = c2 + dc;
-                    if (IsInside(rr, cc) && CheckMatchAt(rr, cc)) return true;
+                    if (Write != i)
+                    {
+                        GridArray[Index(SegmentRows[Write], c)] = Tile;
+                        Tile->SetGridPosition(SegmentRows[Write], c, CellSize, GridOrigin);
+                        GridArray[Index(SegmentRows[i], c)] = nullptr;
+                    }
+                    Write++;
                 }
             }
-            return false;
-        };
 
-    for (int r = 0; r < Rows; ++r)
-    {
-        for (int c = 0; c < Cols; ++c)
-        {
-            // right
-            if (c + 1 < Cols)
+            // fill the rest of the segment
+            for (int32 i = Write; i < Segment.Num; ++i)
             {
-                if (SimSwapCreatesMatch(r, c, r, c + 1)) return true;
+                SpawnTileAt(SegmentRows[i], c, static_cast<ETileColor>(Board.GetCell(SegmentRows[i], c)));
             }
-            // down
-            if (r + 1 < Rows)
+        }
+        return;
+    }
+
+    // shift tiles down column by column
+    for (int c = 0; c < Cols; ++c)
+    {
+        int writeRow = Rows - 1;
+        for (int r = Rows - 1; r >= 0; --r)
+        {
+            // r and c stay inside, no need for GetTileAt's checks
+            AMatchTile* Tile = GridArray[Index(r, c)];
+            if (Tile)
             {
-                if (SimSwapCreatesMatch(r, c, r + 1, c)) return true;
+                if (writeRow != r)
+                {
+                    GridArray[Index(writeRow, c)] = Tile;
+                    Tile->SetGridPosition(writeRow, c, CellSize, GridOrigin);
+                    GridArray[Index(r, c)] = nullptr;
+                }
+                writeRow--;
             }
         }
-    }
 
-    return false;
+        // fill remaining above
+        for (int r = writeRow; r >= 0; --r)
+        {
+            SpawnTileAt(r, c, static_cast<ETileColor>(Board.GetCell(r, c)));
+        }
+    }
 }
 
 
@@ -490,5 +946,3 @@ void AMatch3Grid::DestroyAllTiles()
         }
     }
 }
-
-
@@ -5,8 +5,46 @@
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
 #include "MatchTile.h"
+#include "Match3Board.h"
+#include "Match3Replay.h"
+#include "Match3BoardHost.h"
+#include "Match3Telemetry.h"
+#include "Match3SimThread.h"
+#include "Match3Routine.h"
+#include "Match3Mcts.h"
 #include "Match3Grid.generated.h"
 
+class AMatch3PlayerController;
+
+// raised once per resolved turn with the new total and the points the turn added
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnMatch3ScoreChanged, int32, NewScore, int32, TurnPoints);
+
+// raised as soon as a swap request is checked, also for swaps queued during a cascade
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FOnMatch3SwapChecked, int32, CellA, int32, CellB, bool, bAccepted);
+
+// one resolved turn sent from the server: the swap that started it and the packed
+// board after it (FMatch3Snapshot), delta coded against a board the client acked
+USTRUCT()
+struct FMatch3NetTurn
+{
+    GENERATED_BODY()
+
+    UPROPERTY()
+    int32 Sequence = 0;
+
+    // INDEX_NONE for a full board
+    UPROPERTY()
+    int32 BaseSequence = INDEX_NONE;
+
+    // packed like FMatch3Replay swaps, INDEX_NONE when the board changed without one
+    UPROPERTY()
+    int32 Swap = INDEX_NONE;
+
+    // Match3NetDelta against the base board
+    UPROPERTY()
+    TArray<uint8> Delta;
+};
+
 UCLASS()
 class SATJAM_MATCH3_API AMatch3Grid : public AActor
 {
@@ -16,14 +54,30 @@ public:
     AMatch3Grid();
 
     virtual void BeginPlay() override;
+    virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+    virtual void Tick(float DeltaSeconds) override;
 
     // grid settings
-    UPROPERTY(EditAnywhere, Category = "Grid")
+    // FMatch3Board::MinSize to MaxSize
+    UPROPERTY(EditAnywhere, Category = "Grid", meta = (ClampMin = "3", ClampMax = "32"))
     int32 Rows = 10;
 
-    UPROPERTY(EditAnywhere, Category = "Grid")
+    UPROPERTY(EditAnywhere, Category = "Grid", meta = (ClampMin = "3", ClampMax = "32"))
     int32 Cols = 6;
 
+    // tile colors in play, more makes matches rarer (difficulty); BeginPlay lowers it
+    // to the colors TileClass has materials for
+    UPROPERTY(EditAnywhere, Category = "Grid", meta = (ClampMin = "3", ClampMax = "8"))
+    int32 NumColors = 4;
+
+    // level shape, X = row and Y = column: no tile ever sits in these cells, runs
+    // break at them, tiles fall through holes and rest on blocked cells
+    UPROPERTY(EditAnywhere, Category = "Grid")
+    TArray<FIntPoint> HoleCells;
+
+    UPROPERTY(EditAnywhere, Category = "Grid")
+    TArray<FIntPoint> BlockedCells;
+
     // tile class to spawn (set in Editor)
     UPROPERTY(EditAnywhere, Category = "Grid")
     TSubclassOf<AMatchTile> TileClass;
@@ -36,6 +90,24 @@ public:
     UPROPERTY(EditAnywhere, Category = "Grid")
     FVector GridOrigin = FVector::ZeroVector;
 
+    // rng seed for the board, 0 picks a random one on BeginPlay
+    UPROPERTY(EditAnywhere, Category = "Grid")
+    int32 Seed = 0;
+
+    // take new boards from the game instance's background pool instead of
+    // generating them on the game thread
+    UPROPERTY(EditAnywhere, Category = "Grid")
+    bool bUseBoardPool = true;
+
+    // run the board on the world's UMatch3BoardHost and only show it here
+    UPROPERTY(EditAnywhere, Category = "Grid")
+    bool bUseBoardHost = false;
+
+    // resolve swaps on a simulation thread of this grid's own and only show the
+    // results here, so large boards never stall the game thread
+    UPROPERTY(EditAnywhere, Category = "Grid")
+    bool bUseSimThread = false;
+
     // score and winning
     UPROPERTY(VisibleAnywhere, Category = "Game")
     int32 Score = 0;
@@ -43,15 +115,54 @@ public:
     UPROPERTY(EditAnywhere, Category = "Game")
     int32 PointsPerClear = 100;
 
+    // extra percent per cascade step after the first
+    UPROPERTY(EditAnywhere, Category = "Game")
+    int32 CascadeBonusPercent = 50;
+
     UPROPERTY(EditAnywhere, Category = "Game")
     int32 WinScore = 1000;
 
+    UPROPERTY(BlueprintAssignable, Category = "Game")
+    FOnMatch3ScoreChanged OnScoreChanged;
+
     // prevent player input during clears
     UPROPERTY(VisibleAnywhere, Category = "Game")
     bool bInputLocked = false;
 
-    float ClearDelay = 0.5f;    // Time before clearing
+    float ClearDelay = 0.5f;    // Time before clearing, 0 resolves a turn at once
+
+    // swaps kept while input is locked, checked against the predicted board and
+    // started as soon as the turn ends (0 drops them like before)
+    UPROPERTY(EditAnywhere, Category = "Game", meta = (ClampMin = "0"))
+    int32 MaxQueuedSwaps = 2;
+
+    UPROPERTY(BlueprintAssignable, Category = "Game")
+    FOnMatch3SwapChecked OnSwapChecked;
+
+    // dead boards move their tiles into a new arrangement instead of respawning them
+    UPROPERTY(EditAnywhere, Category = "Game")
+    bool bShuffleDeadBoards = true;
+
+    // cascade steps per turn before the board is regenerated instead
+    UPROPERTY(EditAnywhere, Category = "Game", meta = (ClampMin = "1"))
+    int32 MaxCascadeDepth = 100;
+
+    // record seed and swaps so the session can be saved with SaveReplay
+    UPROPERTY(EditAnywhere, Category = "Replay")
+    bool bRecordReplay = true;
+
+    // stream swaps, cascades, lock times and resolve frame times to
+    // Saved/Telemetry/<grid>_<time>.m3tl (convert with -run=Match3TelemetryCsv)
+    UPROPERTY(EditAnywhere, Category = "Telemetry")
+    bool bRecordTelemetry = false;
 
+    // versus mode: this grid is played by the MCTS AI (FMatch3MctsPlayer)
+    UPROPERTY(EditAnywhere, Category = "AI")
+    bool bAiPlayer = false;
+
+    // thinking time per AI move in seconds
+    UPROPERTY(EditAnywhere, Category = "AI", meta = (EditCondition = "bAiPlayer", ClampMin = "0.01"))
+    float AiMoveBudget = 0.25f;
 
     // public accessors
     AMatchTile* GetTileAt(int32 Row, int32 Col) const;
@@ -60,31 +171,198 @@ public:
     // swap two tiles (called by player controller)
     void AttemptSwap(AMatchTile* A, AMatchTile* B);
 
+    // swap two cells now, or queue it if a cascade is running
+    void RequestSwap(int32 CellA, int32 CellB);
+
     // regenerate grid (used on start and if no moves)
     void RegenerateGrid();
 
+    // rearrange the existing tiles on a dead board, false if no arrangement was found
+    bool ShuffleGrid();
+
+    // write the recorded session to a file for FMatch3Replay playback
+    // only valid between turns, the board has to be settled
+    UFUNCTION(BlueprintCallable, Category = "Replay")
+    bool SaveReplay(const FString& Filename);
+
+    // packed board snapshot (colors, score, rng and lock state), see FMatch3Snapshot
+    UFUNCTION(BlueprintCallable, Category = "Snapshot")
+    bool SaveSnapshot(const FString& Filename, bool bAppend = false);
+
+    // restore record Index of a snapshot file through a memory mapping
+    UFUNCTION(BlueprintCallable, Category = "Snapshot")
+    bool LoadSnapshot(const FString& Filename, int32 Index = 0);
+
+    // server: send the settled board to clients as one turn, Swap INDEX_NONE for none
+    void SendTurnToClients(int32 Swap);
+
+    // server: same with a board the owner already packed (the host's or the sim thread's),
+    // for followers whose own board is still animating behind it
+    void SendTurnToClients(int32 Sequence, int32 Swap, TConstArrayView<uint8> Snapshot);
+
+    // server: full board for a client that just joined
+    void SendBoardTo(AMatch3PlayerController* Controller);
+
+    // queue a board from the server or the board host; the swap that led to it is
+    // replayed with the local rules and timers, then checked against the snapshot
+    void QueueAuthoritativeTurn(int32 Sequence, int32 Swap, TArray<uint8>&& Snapshot);
+
+    FMatch3BoardHandle GetHostHandle() const { return HostHandle; }
+
+    // client: decode a turn against the boards we already have and play it
+    // returns false if its base board is gone, the server then sends a full one
+    bool ReceiveNetTurn(const FMatch3NetTurn& Turn);
+
+    const FMatch3Board& GetBoard() const { return Board; }
+    const FMatch3CascadeStats& GetCascadeStats() const { return Board.CascadeStats; }
+
 protected:
+    // rules and colors, tile actors follow it
+    FMatch3Board Board;
+
+    FMatch3Replay Replay;
+
     // internal grid storage (flattened)
     TArray<AMatchTile*> GridArray;
 
-    TArray<AMatchTile*> PendingClearMatches;
-    FTimerHandle ClearTimerHandle;
+    // ShuffleGrid scratch
+    FMatch3CellList ShuffleSource;
+    TArray<AMatchTile*> ShuffleTiles;
+
+    // board after the running turn and every queued swap resolved
+    // same seed and stream as Board, so it is exactly what Board will become
+    FMatch3Board PredictedBoard;
+
+    // the predicted turns end on a dead board, queued swaps are refused until it is replaced
+    bool bPredictedRegenerate = false;
+
+    // accepted swaps waiting for the running turn, oldest first (X = CellA, Y = CellB)
+    TArray<FIntPoint> QueuedSwaps;
+
+    // groups of the next cascade step and its depth (1 = the swap's own match)
+    FMatch3GroupBuffer PendingGroups;
+    int32 CascadeDepth = 0;
+
+    // packed swap of the running turn, INDEX_NONE if none
+    int32 CurrentSwap = INDEX_NONE;
+
+    // the running turn's cascade, reset to cancel it
+    FMatch3Routine Cascade;
+    bool bHasWon = false;
+
+    // session telemetry, null unless bRecordTelemetry
+    TUniquePtr<FMatch3TelemetryWriter> Telemetry;
+
+    // when the running turn locked input
+    uint64 LockStartCycles = 0;
+
+    void RecordTelemetry(EMatch3TelemetryEvent Type, int32 A = 0, int32 B = 0)
+    {
+        if (Telemetry)
+        {
+            Telemetry->Record(Type, A, B);
+        }
+    }
 
 
     // helpers
     inline int32 Index(int32 Row, int32 Col) const { return Row * Cols + Col; }
 
-    void FillGridRandomly();
-    bool HasAnyMatches() const;
-    TArray<AMatchTile*> FindAllMatches() const;
-    void ClearMatches(const TArray<AMatchTile*>& Matches);
-    void ApplyGravityAndRefill();
-    bool HasPossibleMove() const;
+    void ClearMatches();
+
+    // keep a swap on the board and start its cascade, false if it makes no match
+    // bPredict resolves the turn on PredictedBoard for swaps queued behind it
+    bool StartSwap(int32 CellA, int32 CellB, bool bPredict);
+
+    // move tiles down to match the board after its gravity, spawn the refills
+    void DropAndSpawnTiles();
+
+    // keep a swap in GridArray and move the two tiles
+    void SwapTiles(int32 CellA, int32 CellB);
+
+    // destroy the tiles of cleared cells
+    void RemoveTiles(TConstArrayView<int32> InCells);
+
+    // move the existing tiles after a shuffle, Source[i] is the old cell of the color now at i
+    void MoveShuffledTiles(TConstArrayView<int32> Source);
+
+    // one turn: wait for the presentation delay, clear a step, repeat, then FinishTurn
+    FMatch3Routine RunCascade();
+
+    // ClearDelay, or 0 without rendering (dedicated server, -nullrhi)
+    float GetClearDelay() const;
+
+    // destroy the pending groups' tiles and run one cascade step on the board
+    // returns true if another step follows
+    bool ClearPendingGroups();
+
+    // commit the turn's score, notify once, then check win and dead board
+    void FinishTurn();
+
+    // telemetry, score event and win check for a turn whose score is in Board.Score
+    void ReportTurn(int32 CellsCleared, int32 TurnPoints);
+
+    // networking: recent packed boards by sequence, the delta bases on both sides
+    static constexpr int32 NetHistorySize = 16;
+    TArray<uint8> NetHistory[NetHistorySize];
+    int32 NetHistorySequence[NetHistorySize];
+
+    // server: last sequence sent; client and host follower: last sequence played
+    int32 NetSequence = 0;
+
+    // clients ack what they decoded, sends a packed history slot as a delta against it
+    void SendNetHistory(int32 Sequence, int32 Swap);
+
+    // board on the world's host when bUseBoardHost is set
+    FMatch3BoardHandle HostHandle;
+    FDelegateHandle HostTurnDelegate;
+
+    // board on a simulation thread when bUseSimThread is set, drained in Tick
+    TUniquePtr<FMatch3SimThread> SimThread;
+    FMatch3SimEvent SimEvent;
+
+    // the thread's events waiting to be shown, oldest first; the rules already ran
+    // there, these only move tiles
+    TArray<FMatch3SimEvent> SimEvents;
+
+    // run as Cascade: show SimEvents in order, waiting the clear delay before each step
+    FMatch3Routine PlaySimEvents();
+    void ShowSimEvent(const FMatch3SimEvent& Event);
+
+    // searches on worker threads while the board is free, polled in Tick
+    TUniquePtr<FMatch3MctsPlayer> Ai;
+
+    // the board is owned elsewhere (server, host or simulation thread), this grid only follows it
+    bool IsFollower() const { return IsNetClient() || HostHandle.IsValid() || SimThread.IsValid(); }
+
+    void OnHostTurn(FMatch3BoardHandle Handle, int32 Sequence, int32 Swap, bool bAccepted);
+
+    // the owner checked a forwarded swap (packed like FMatch3Replay swaps)
+    void NotifySwapChecked(int32 Swap, bool bAccepted);
+
+    // client or host follower: turns waiting for the running one to finish animating
+    TArray<FMatch3NetTurn> PendingNetTurns;
+
+    // set once BeginPlay has initialized Board; turns received earlier wait in PendingNetTurns
+    bool bBoardReady = false;
+
+    // client: the server's board after the running turn
+    TArray<uint8> NetAuthoritative;
+    TArray<uint8> NetScratch;
+
+    bool IsNetClient() const { return GetNetMode() == NM_Client; }
+
+    // client: replay queued turns with the local rules while the board is free
+    void PlayNetTurns();
+
+    // client: snap to NetAuthoritative if the local result differs
+    void CheckNetBoard();
 
-    void StartClear(const TArray<AMatchTile*>& Matches);
-    void PerformClear();
+    // replace the board with a snapshot and respawn its tiles, false on a bad snapshot
+    bool ShowBoard(TConstArrayView<uint8> Snapshot);
 
     // utility
     void DestroyAllTiles();
+    void SpawnAllTiles();
     void SpawnTileAt(int32 Row, int32 Col, ETileColor Color);
 };
@@ -0,0 +1,192 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Match3Groups.h"
+#include "Match3Board.h"
+
+void FMatch3GroupBuffer::Build(const FMatch3Board& Board)
+{
+    Board.FindAllMatches(MatchedCells);
+    BuildFromMatches(Board);
+}
+
+
+void FMatch3GroupBuffer::Reserve(int32 NumBoardCells)
+{
+    // a group has at least three cells
+    Groups.Reserve(NumBoardCells / 3 + 1);
+    GroupCells.Reserve(NumBoardCells);
+    MatchedCells.Reserve(NumBoardCells);
+
+    if (Parent.Num() != NumBoardCells)
+    {
+        Parent.Init(INDEX_NONE, NumBoardCells);
+        CellGroup.Init(INDEX_NONE, NumBoardCells);
+    }
+}
+
+
+void FMatch3GroupBuffer::Reset()
+{
+    Groups.Reset();
+    GroupCells.Reset();
+    MatchedCells.Reset();
+}
+
+
+int32 FMatch3GroupBuffer::FindRoot(int32 Cell)
+{
+    // path halving
+    while (Parent[Cell] != Cell)
+    {
+        Parent[Cell] = Parent[Parent[Cell]];
+        Cell = Parent[Cell];
+    }
+    return Cell;
+}
+
+
+void FMatch3GroupBuffer::BuildFromMatches(const FMatch3Board& Board)
+{
+    Groups.Reset();
+    GroupCells.Reset();
+
+    Reserve(Board.Num());
+
+    const int32 Cols = Board.Cols;
+
+    // union-find over matched cells, merging with the left and upper neighbor of the same color
+    for (int32 Cell : MatchedCells)
+    {
+        Parent[Cell] = Cell;
+    }
+
+    for (int32 Cell : MatchedCells)
+    {
+        const uint8 Color = Board.Cells[Cell];
+
+        auto Merge = [&](int32 Other)
+            {
+                if (Parent[Other] == INDEX_NONE || Board.Cells[Other] != Color) return;
+
+                const int32 RootA = FindRoot(Cell);
+                const int32 RootB = FindRoot(Other);
+                if (RootA != RootB)
+                {
+                    Parent[FMath::Max(RootA, RootB)] = FMath::Min(RootA, RootB);
+                }
+            };
+
+        if (Cell % Cols > 0) Merge(Cell - 1);
+        if (Cell >= Cols) Merge(Cell - Cols);
+    }
+
+    // number the groups in order of first appearance and count their cells
+    for (int32 Cell : MatchedCells)
+    {
+        const int32 Root = FindRoot(Cell);
+        if (CellGroup[Root] == INDEX_NONE)
+        {
+            FMatch3Group& Group = Groups.AddDefaulted_GetRef();
+            Group.Color = Board.Cells[Root];
+            CellGroup[Root] = Groups.Num() - 1;
+        }
+        CellGroup[Cell] = CellGroup[Root];
+        Groups[CellGroup[Cell]].NumCells++;
+    }
+
+    // lay the cells out contiguously per group
+    int32 First = 0;
+    for (FMatch3Group& Group : Groups)
+    {
+        Group.FirstCell = First;
+        First += Group.NumCells;
+        Group.NumCells = 0;
+    }
+
+    GroupCells.SetNumUninitialized(MatchedCells.Num());
+    for (int32 Cell : MatchedCells)
+    {
+        FMatch3Group& Group = Groups[CellGroup[Cell]];
+        GroupCells[Group.FirstCell + Group.NumCells++] = Cell;
+    }
+
+    for (int32 i = 0; i < Groups.Num(); ++i)
+    {
+        Groups[i].Shape = Classify(Board, i);
+    }
+
+    // leave the scratch clean for the next call
+    for (int32 Cell : MatchedCells)
+    {
+        Parent[Cell] = INDEX_NONE;
+        CellGroup[Cell] = INDEX_NONE;
+    }
+}
+
+
+EMatch3Shape FMatch3GroupBuffer::Classify(const FMatch3Board& Board, int32 GroupIndex) const
+{
+    const FMatch3Group& Group = Groups[GroupIndex];
+    const int32 Rows = Board.Rows;
+    const int32 Cols = Board.Cols;
+
+    // collect the 3+ runs of the group, walking each run once from its start
+    int32 NumH = 0, HStart = 0, HLen = 0;
+    int32 NumV = 0, VStart = 0, VLen = 0;
+
+    for (int32 Cell : GetCells(Group))
+    {
+        const int32 r = Cell / Cols;
+        const int32 c = Cell % Cols;
+
+        if (c == 0 || CellGroup[Cell - 1] != GroupIndex)
+        {
+            int32 Len = 1;
+            while (c + Len < Cols && CellGroup[Cell + Len] == GroupIndex) Len++;
+            if (Len >= 3)
+            {
+                NumH++;
+                HStart = Cell;
+                HLen = Len;
+            }
+        }
+
+        if (r == 0 || CellGroup[Cell - Cols] != GroupIndex)
+        {
+            int32 Len = 1;
+            while (r + Len < Rows && CellGroup[Cell + Len * Cols] == GroupIndex) Len++;
+            if (Len >= 3)
+            {
+                NumV++;
+                VStart = Cell;
+                VLen = Len;
+            }
+        }
+    }
+
+    // a single straight run
+    if (NumH + NumV == 1)
+    {
+        const int32 Len = FMath::Max(HLen, VLen);
+        if (Group.NumCells != Len) return EMatch3Shape::Other;
+        if (Len >= 5) return EMatch3Shape::Line5;
+        return Len == 4 ? EMatch3Shape::Line4 : EMatch3Shape::Line3;
+    }
+
+    // one horizontal and one vertical run sharing a cell
+    if (NumH == 1 && NumV == 1 && Group.NumCells == HLen + VLen - 1)
+    {
+        const int32 HPos = VStart % Cols - HStart % Cols;
+        const int32 VPos = HStart / Cols - VStart / Cols;
+        if (HPos < 0 || HPos >= HLen || VPos < 0 || VPos >= VLen) return EMatch3Shape::Other;
+
+        const bool bHEnd = HPos == 0 || HPos == HLen - 1;
+        const bool bVEnd = VPos == 0 || VPos == VLen - 1;
+        if (bHEnd && bVEnd) return EMatch3Shape::L;
+        if (bHEnd || bVEnd) return EMatch3Shape::T;
+        return EMatch3Shape::Cross;
+    }
+
+    return EMatch3Shape::Other;
+}
@@ -0,0 +1,67 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Match3Scratch.h"
+
+struct FMatch3Board;
+
+// shape of one connected group of matched cells
+enum class EMatch3Shape : uint8
+{
+    Line3,
+    Line4,
+    Line5,      // 5 or more in a line
+    L,
+    T,
+    Cross,
+    Other       // anything else, e.g. two parallel lines touching
+};
+
+struct FMatch3Group
+{
+    // range in FMatch3GroupBuffer::GroupCells
+    int32 FirstCell = 0;
+    int32 NumCells = 0;
+
+    uint8 Color = 0;
+    EMatch3Shape Shape = EMatch3Shape::Other;
+};
+
+// matched cells split into connected same-color groups, reused between calls
+// so scoring, special tiles and analytics share one labeling pass
+struct SATJAM_MATCH3_API FMatch3GroupBuffer
+{
+    TArray<FMatch3Group, FMatch3ScratchAllocator> Groups;
+
+    // cells of every group, contiguous per group
+    FMatch3CellList GroupCells;
+
+    // all matched cells, same as FMatch3Board::FindAllMatches
+    FMatch3CellList MatchedCells;
+
+    // size every buffer for a board so no later Build allocates
+    void Reserve(int32 NumBoardCells);
+
+    // find matches on the board and label them, linear in the number of matched cells
+    void Build(const FMatch3Board& Board);
+
+    // label an already found set of matched cells (any order)
+    void BuildFromMatches(const FMatch3Board& Board);
+
+    void Reset();
+
+    TConstArrayView<int32> GetCells(const FMatch3Group& Group) const
+    {
+        return MakeArrayView(GroupCells.GetData() + Group.FirstCell, Group.NumCells);
+    }
+
+private:
+    // per cell scratch, INDEX_NONE outside of a Build call
+    FMatch3CellList Parent;
+    FMatch3CellList CellGroup;
+
+    int32 FindRoot(int32 Cell);
+    EMatch3Shape Classify(const FMatch3Board& Board, int32 GroupIndex) const;
+};
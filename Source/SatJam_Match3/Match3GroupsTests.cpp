@@ -0,0 +1,108 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Match3Groups.h"
+#include "Match3Board.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    // rows split by '/': X is color 0, Y is color 3, anything else a filler of
+    // colors 1 and 2 alternating, which never lines up three
+    void MakeBoard(FMatch3Board& Board, const TCHAR* Picture)
+    {
+        int32 Cols = 0;
+        while (Picture[Cols] != TEXT('\0') && Picture[Cols] != TEXT('/')) Cols++;
+        const int32 Rows = (FCString::Strlen(Picture) + 1) / (Cols + 1);
+        Board.Init(Rows, Cols, 1);
+
+        for (int32 r = 0; r < Rows; ++r)
+        {
+            for (int32 c = 0; c < Cols; ++c)
+            {
+                const TCHAR Cell = Picture[r * (Cols + 1) + c];
+                const uint8 Filler = static_cast<uint8>(1 + (r + c) % 2);
+                Board.SetCell(r, c, Cell == TEXT('X') ? 0 : Cell == TEXT('Y') ? 3 : Filler);
+            }
+        }
+    }
+
+    struct FShapeCase
+    {
+        const TCHAR* Name;
+        const TCHAR* Picture;
+        EMatch3Shape Shape;
+        int32 NumCells;
+    };
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMatch3GroupsClassifyTest, "SatJam.Match3.Groups.Classify",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FMatch3GroupsClassifyTest::RunTest(const FString& Parameters)
+{
+    const FShapeCase Cases[] = {
+        { TEXT("line of 3"), TEXT("......./..XXX../......."), EMatch3Shape::Line3, 3 },
+        { TEXT("vertical line of 3"), TEXT("...X.../...X.../...X.../......."), EMatch3Shape::Line3, 3 },
+        { TEXT("line of 4"), TEXT("......./XXXX.../......."), EMatch3Shape::Line4, 4 },
+        { TEXT("line of 5"), TEXT("......./.XXXXX./......."), EMatch3Shape::Line5, 5 },
+        { TEXT("line of 6"), TEXT("......./XXXXXX./......."), EMatch3Shape::Line5, 6 },
+        { TEXT("vertical line of 5"), TEXT(".X...../.X...../.X...../.X...../.X....."), EMatch3Shape::Line5, 5 },
+        { TEXT("L"), TEXT("X....../X....../XXX...."), EMatch3Shape::L, 5 },
+        { TEXT("mirrored L"), TEXT("....XXX/......X/......X"), EMatch3Shape::L, 5 },
+        { TEXT("T"), TEXT(".XXX.../..X..../..X...."), EMatch3Shape::T, 5 },
+        { TEXT("sideways T"), TEXT("X....../XXX..../X......"), EMatch3Shape::T, 5 },
+        { TEXT("cross"), TEXT("..X..../.XXX.../..X...."), EMatch3Shape::Cross, 5 },
+        { TEXT("run of 5 with a leg at its end"), TEXT("XXXXX../X....../X......"), EMatch3Shape::L, 7 },
+        { TEXT("run of 5 with a leg in its middle"), TEXT("XXXXX../..X..../..X...."), EMatch3Shape::T, 7 },
+        { TEXT("long runs crossing"), TEXT("..X..../..X..../XXXXX../..X..../..X...."), EMatch3Shape::Cross, 9 },
+        { TEXT("parallel runs touching"), TEXT("......./.XXX.../.XXX.../......."), EMatch3Shape::Other, 6 },
+        { TEXT("run with a stray neighbor"), TEXT("......./.XXX.../.X...../......."), EMatch3Shape::Line3, 3 },
+    };
+
+    FMatch3Board Board;
+    FMatch3GroupBuffer Groups;
+    for (const FShapeCase& Case : Cases)
+    {
+        MakeBoard(Board, Case.Picture);
+
+        Groups.Build(Board);
+        if (!TestEqual(FString::Printf(TEXT("%s: one group"), Case.Name), Groups.Groups.Num(), 1)) continue;
+
+        const FMatch3Group& Group = Groups.Groups[0];
+        TestEqual(FString::Printf(TEXT("%s: shape"), Case.Name), static_cast<int32>(Group.Shape), static_cast<int32>(Case.Shape));
+        TestEqual(FString::Printf(TEXT("%s: cells"), Case.Name), Group.NumCells, Case.NumCells);
+        TestEqual(FString::Printf(TEXT("%s: color"), Case.Name), static_cast<int32>(Group.Color), 0);
+    }
+    return true;
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMatch3GroupsSeparateTest, "SatJam.Match3.Groups.Separate",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FMatch3GroupsSeparateTest::RunTest(const FString& Parameters)
+{
+    // touching groups of different colors, and two of one color apart
+    FMatch3Board Board;
+    MakeBoard(Board, TEXT("XXX..../YYYY.../......./....XXX"));
+
+    FMatch3GroupBuffer Groups;
+    Groups.Build(Board);
+    if (!TestEqual(TEXT("three groups"), Groups.Groups.Num(), 3)) return true;
+
+    int32 NumLine3 = 0;
+    int32 NumLine4 = 0;
+    for (const FMatch3Group& Group : Groups.Groups)
+    {
+        NumLine3 += Group.Shape == EMatch3Shape::Line3 && Group.Color == 0 ? 1 : 0;
+        NumLine4 += Group.Shape == EMatch3Shape::Line4 && Group.Color == 3 ? 1 : 0;
+    }
+    TestEqual(TEXT("two lines of 3 in color 0"), NumLine3, 2);
+    TestEqual(TEXT("one line of 4 in color 3"), NumLine4, 1);
+    return true;
+}
+
+#endif
@@ -0,0 +1,91 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Match3Board.h"
+#include "Match3BoardKernels.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    // the sizes with a kernel, see Match3Kernels::Find
+    const FIntPoint KernelSizes[] = { { 10, 6 }, { 6, 10 }, { 8, 8 }, { 7, 7 }, { 6, 6 } };
+
+    // random colors without the generator's rules, so boards have matches too
+    void FillAnyColors(FMatch3Board& Board, FRandomStream& Stream)
+    {
+        for (uint8& Color : Board.Cells)
+        {
+            Color = static_cast<uint8>(Stream.RandRange(0, Board.NumColors - 1));
+        }
+        Board.CellsChanged();
+    }
+
+    TArray<int32> Sorted(const FMatch3CellList& Cells)
+    {
+        TArray<int32> Result(Cells.GetData(), Cells.Num());
+        Result.Sort();
+        return Result;
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMatch3KernelEquivalenceTest, "SatJam.Match3.Kernels.MatchesGeneric",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FMatch3KernelEquivalenceTest::RunTest(const FString& Parameters)
+{
+    FMatch3CellList KernelCells;
+    FMatch3CellList GenericCells;
+    FMatch3MoveList KernelMoves;
+    FMatch3MoveList GenericMoves;
+
+    for (const FIntPoint& Size : KernelSizes)
+    {
+        for (int32 NumColors = FMatch3Board::MinColors; NumColors <= FMatch3Board::MaxColors; ++NumColors)
+        {
+            FMatch3Board Board;
+            Board.Init(Size.X, Size.Y, NumColors);
+            Board.SetNumColors(NumColors);
+            if (!TestNotNull(TEXT("size has a kernel"), Board.Kernel)) continue;
+
+            // the same board through the generic loops
+            FMatch3Board Generic = Board;
+            Generic.Kernel = nullptr;
+
+            FRandomStream Stream(Size.X * 100 + Size.Y * 10 + NumColors);
+            for (int32 i = 0; i < 200; ++i)
+            {
+                // alternate random boards (matches) with generated ones (moves, no matches)
+                if (i % 2 == 0)
+                {
+                    FillAnyColors(Board, Stream);
+                }
+                else
+                {
+                    Board.RegenerateFromSeed(static_cast<int32>(Stream.GetUnsignedInt()));
+                }
+                Generic.CopyCellsFrom(Board);
+
+                Board.FindAllMatches(KernelCells);
+                Generic.FindAllMatches(GenericCells);
+                TestTrue(TEXT("FindAllMatches"), Sorted(KernelCells) == Sorted(GenericCells));
+                TestEqual(TEXT("HasAnyMatches"), Board.HasAnyMatches(), Generic.HasAnyMatches());
+                TestEqual(TEXT("HasPossibleMove"), Board.HasPossibleMove(), Generic.HasPossibleMove());
+
+                // same moves in the same order, horizontal then vertical by CellA
+                Board.FindAllMoves(KernelMoves);
+                Generic.FindAllMoves(GenericMoves);
+                if (!TestEqual(TEXT("FindAllMoves count"), KernelMoves.Moves.Num(), GenericMoves.Moves.Num())) continue;
+                for (int32 m = 0; m < KernelMoves.Moves.Num(); ++m)
+                {
+                    TestEqual(TEXT("FindAllMoves CellA"), KernelMoves.Moves[m].CellA, GenericMoves.Moves[m].CellA);
+                    TestEqual(TEXT("FindAllMoves CellB"), KernelMoves.Moves[m].CellB, GenericMoves.Moves[m].CellB);
+                }
+            }
+        }
+    }
+    return true;
+}
+
+#endif
@@ -0,0 +1,383 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Match3Mcts.h"
+#include "Async/ParallelFor.h"
+#include "Async/TaskGraphInterfaces.h"
+void FMatch3MctsTree::Reset(const FMatch3Board& InBoard)
+{
+    Board = InBoard;
+    RootHash = Board.Hash;
+    NumCells = Board.Num();
+    Moves.Reserve(NumCells);
+
+    Nodes.Reset();
+    Edges.Reset();
+    Outcomes.Reset();
+    Cells.Reset();
+    MaxReward = 0.0;
+
+    Nodes.AddDefaulted();
+    Cells.Append(Board.Cells);
+}
+
+
+bool FMatch3MctsTree::Advance(const FMatch3Board& InBoard)
+{
+    if (Nodes.Num() == 0 || InBoard.Num() != NumCells) return false;
+
+    // no turn was played since the last search
+    if (InBoard.Hash == RootHash && NodeMatches(0, InBoard.Cells))
+    {
+        Board = InBoard;
+        return true;
+    }
+
+    const uint64 Hash = InBoard.Hash;
+    const FNode& Root = Nodes[0];
+    for (int32 Edge = Root.FirstEdge; Edge != INDEX_NONE && Edge < Root.FirstEdge + Root.NumEdges; ++Edge)
+    {
+        for (int32 Outcome = Edges[Edge].FirstOutcome; Outcome != INDEX_NONE; Outcome = Outcomes[Outcome].Next)
+        {
+            if (Outcomes[Outcome].Hash == Hash && NodeMatches(Outcomes[Outcome].Node, InBoard.Cells))
+            {
+                Board = InBoard;
+                RootHash = Hash;
+                Rebase(Outcomes[Outcome].Node);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+
+void FMatch3MctsTree::Search(double Deadline, const TAtomic<bool>& bCancelled, const FMatch3MctsSettings& Settings, int32 Seed)
+{
+    Rand.Initialize(Seed);
+    MaxNodes = FMath::Max(1, Settings.MaxNodes);
+    PathNodes.Reset();
+    PathEdges.Reset();
+    PathPoints.Reset();
+
+    Iterations = 0;
+    for (;;)
+    {
+        RunIteration(Settings);
+        ++Iterations;
+
+        // the clock costs more than a rollout on small boards
+        if ((Iterations & 15) == 0 && (bCancelled || FPlatformTime::Seconds() >= Deadline)) break;
+    }
+}
+
+
+int32 FMatch3MctsTree::NumRootMoves() const
+{
+    return Nodes.Num() > 0 ? Nodes[0].NumEdges : 0;
+}
+
+
+void FMatch3MctsTree::GetRootMove(int32 Index, int32& OutCellA, int32& OutCellB, int32& OutVisits) const
+{
+    const FEdge& Edge = Edges[Nodes[0].FirstEdge + Index];
+    OutCellA = Edge.CellA;
+    OutCellB = Edge.CellB;
+    OutVisits = Edge.Visits;
+}
+
+
+void FMatch3MctsTree::RunIteration(const FMatch3MctsSettings& Settings)
+{
+    // each iteration sees its own refills
+    FMemory::Memcpy(Board.Cells.GetData(), Cells.GetData(), NumCells);
+    Board.CellsChanged();
+    Board.Score = 0;
+    Board.Stream.Initialize(Rand.RandHelper(MAX_int32));
+
+    PathNodes.Reset();
+    PathEdges.Reset();
+    PathPoints.Reset();
+
+    int32 Node = 0;
+    int32 RolloutPoints = 0;
+    for (;;)
+    {
+        PathNodes.Add(Node);
+        if (Nodes[Node].FirstEdge == INDEX_NONE)
+        {
+            Expand(Node);
+        }
+        if (Nodes[Node].NumEdges == 0) break;
+
+        const int32 Edge = SelectEdge(Node, Settings.Exploration);
+        int32 Points = 0;
+        const bool bAlive = PlayTurn(Edges[Edge].CellA, Edges[Edge].CellB, Points);
+        PathEdges.Add(Edge);
+        PathPoints.Add(Points);
+        if (!bAlive) break;
+
+        // follow the refill this simulation made, a new one ends the tree walk
+        const uint64 Hash = Board.Hash;
+        const int32 Child = FindOutcome(Edge, Hash);
+        if (Child == INDEX_NONE)
+        {
+            AddNode(Edge, Hash);
+            RolloutPoints = Rollout(Settings.RolloutTurns);
+            break;
+        }
+        Node = Child;
+    }
+
+    // each edge earns the points from its own turn on
+    double Reward = RolloutPoints;
+    for (int32 i = PathEdges.Num() - 1; i >= 0; --i)
+    {
+        Reward += PathPoints[i];
+        FEdge& Edge = Edges[PathEdges[i]];
+        Edge.Visits++;
+        Edge.TotalReward += Reward;
+        MaxReward = FMath::Max(MaxReward, Reward);
+    }
+    for (int32 PathNode : PathNodes)
+    {
+        Nodes[PathNode].Visits++;
+    }
+}
+
+
+void FMatch3MctsTree::Expand(int32 Node)
+{
+    Board.FindAllMoves(Moves);
+
+    Nodes[Node].FirstEdge = Edges.Num();
+    Nodes[Node].NumEdges = Moves.Moves.Num();
+    for (const FMatch3Move& Move : Moves.Moves)
+    {
+        FEdge& Edge = Edges.AddDefaulted_GetRef();
+        Edge.CellA = Move.CellA;
+        Edge.CellB = Move.CellB;
+    }
+}
+
+
+int32 FMatch3MctsTree::SelectEdge(int32 Node, float Exploration) const
+{
+    const FNode& Parent = Nodes[Node];
+    const double Scale = MaxReward > 0.0 ? 1.0 / MaxReward : 1.0;
+    const double LogVisits = FMath::Loge(static_cast<double>(FMath::Max(1, Parent.Visits)));
+
+    int32 Best = Parent.FirstEdge;
+    double BestValue = -1.0;
+    for (int32 Edge = Parent.FirstEdge; Edge < Parent.FirstEdge + Parent.NumEdges; ++Edge)
+    {
+        const FEdge& Candidate = Edges[Edge];
+        if (Candidate.Visits == 0) return Edge;
+
+        const double Value = Candidate.TotalReward * Scale / Candidate.Visits
+            + Exploration * FMath::Sqrt(LogVisits / Candidate.Visits);
+        if (Value > BestValue)
+        {
+            BestValue = Value;
+            Best = Edge;
+        }
+    }
+    return Best;
+}
+
+
+bool FMatch3MctsTree::PlayTurn(int32 CellA, int32 CellB, int32& OutPoints)
+{
+    const int32 Before = Board.Score;
+    int32 Depth = 0;
+    const bool bAlive = Board.TrySwap(CellA, CellB) && (!Board.ResolveCascade(Depth) || Board.TryShuffleDeadBoard());
+    OutPoints = Board.Score - Before;
+    return bAlive;
+}
+
+
+int32 FMatch3MctsTree::Rollout(int32 Turns)
+{
+    int32 Points = 0;
+    for (int32 Turn = 0; Turn < Turns; ++Turn)
+    {
+        Board.FindAllMoves(Moves);
+        if (Moves.Moves.Num() == 0) break;
+
+        const FMatch3Move& Move = Moves.Moves[Rand.RandHelper(Moves.Moves.Num())];
+        int32 TurnPoints = 0;
+        const bool bAlive = PlayTurn(Move.CellA, Move.CellB, TurnPoints);
+        Points += TurnPoints;
+        if (!bAlive) break;
+    }
+    return Points;
+}
+
+
+int32 FMatch3MctsTree::FindOutcome(int32 Edge, uint64 Hash) const
+{
+    for (int32 Outcome = Edges[Edge].FirstOutcome; Outcome != INDEX_NONE; Outcome = Outcomes[Outcome].Next)
+    {
+        if (Outcomes[Outcome].Hash == Hash && NodeMatches(Outcomes[Outcome].Node, Board.Cells))
+        {
+            return Outcomes[Outcome].Node;
+        }
+    }
+    return INDEX_NONE;
+}
+
+
+int32 FMatch3MctsTree::AddNode(int32 Edge, uint64 Hash)
+{
+    if (Nodes.Num() >= MaxNodes) return INDEX_NONE;
+
+    const int32 Node = Nodes.AddDefaulted();
+    Cells.Append(Board.Cells);
+
+    FOutcome& Outcome = Outcomes.AddDefaulted_GetRef();
+    Outcome.Hash = Hash;
+    Outcome.Node = Node;
+    Outcome.Next = Edges[Edge].FirstOutcome;
+    Edges[Edge].FirstOutcome = Outcomes.Num() - 1;
+    return Node;
+}
+
+
+bool FMatch3MctsTree::NodeMatches(int32 Node, const TArray<uint8>& InCells) const
+{
+    return FMemory::Memcmp(Cells.GetData() + static_cast<int64>(Node) * NumCells, InCells.GetData(), NumCells) == 0;
+}
+
+
+void FMatch3MctsTree::Rebase(int32 NewRoot)
+{
+    TArray<FNode> OldNodes = MoveTemp(Nodes);
+    TArray<FEdge> OldEdges = MoveTemp(Edges);
+    TArray<FOutcome> OldOutcomes = MoveTemp(Outcomes);
+    TArray<uint8> OldCells = MoveTemp(Cells);
+
+    // breadth first copy, nodes are renumbered in the order they are reached
+    TArray<int32> Queue;
+    Queue.Add(NewRoot);
+    Nodes.Add(OldNodes[NewRoot]);
+    Cells.Append(OldCells.GetData() + static_cast<int64>(NewRoot) * NumCells, NumCells);
+
+    for (int32 Next = 0; Next < Queue.Num(); ++Next)
+    {
+        const FNode& Old = OldNodes[Queue[Next]];
+        if (Old.FirstEdge == INDEX_NONE) continue;
+
+        Nodes[Next].FirstEdge = Edges.Num();
+        for (int32 OldEdge = Old.FirstEdge; OldEdge < Old.FirstEdge + Old.NumEdges; ++OldEdge)
+        {
+            FEdge Edge = OldEdges[OldEdge];
+            Edge.FirstOutcome = INDEX_NONE;
+            for (int32 Outcome = OldEdges[OldEdge].FirstOutcome; Outcome != INDEX_NONE; Outcome = OldOutcomes[Outcome].Next)
+            {
+                const int32 OldChild = OldOutcomes[Outcome].Node;
+                const int32 Child = Nodes.Add(OldNodes[OldChild]);
+                Cells.Append(OldCells.GetData() + static_cast<int64>(OldChild) * NumCells, NumCells);
+                Queue.Add(OldChild);
+
+                FOutcome& Copy = Outcomes.AddDefaulted_GetRef();
+                Copy.Hash = OldOutcomes[Outcome].Hash;
+                Copy.Node = Child;
+                Copy.Next = Edge.FirstOutcome;
+                Edge.FirstOutcome = Outcomes.Num() - 1;
+            }
+            Edges.Add(Edge);
+        }
+    }
+}
+
+
+FMatch3MctsPlayer::FMatch3MctsPlayer(const FMatch3MctsSettings& InSettings)
+    : Settings(InSettings)
+    , Seeds(FMath::Rand())
+{
+    const int32 NumTrees = Settings.NumTrees > 0 ? Settings.NumTrees : FMath::Max(1, FTaskGraphInterface::Get().GetNumWorkerThreads());
+    Trees.SetNum(NumTrees);
+}
+
+
+FMatch3MctsPlayer::~FMatch3MctsPlayer()
+{
+    bCancelled = true;
+    Task.Wait();
+}
+
+
+void FMatch3MctsPlayer::StartSearch(const FMatch3Board& Board)
+{
+    check(!bSearching);
+
+    SearchBoard = Board;
+    DecisionA = INDEX_NONE;
+    DecisionB = INDEX_NONE;
+    bSearching = true;
+
+    Task = UE::Tasks::Launch(UE_SOURCE_LOCATION, [this]() { RunSearch(); });
+}
+
+
+bool FMatch3MctsPlayer::TryGetDecision(int32& OutCellA, int32& OutCellB)
+{
+    if (!bSearching || !Task.IsCompleted()) return false;
+
+    bSearching = false;
+    OutCellA = DecisionA;
+    OutCellB = DecisionB;
+    return DecisionA != INDEX_NONE;
+}
+
+
+void FMatch3MctsPlayer::RunSearch()
+{
+    const double Deadline = FPlatformTime::Seconds() + Settings.TimeBudgetSeconds;
+    TArray<int32, TInlineAllocator<16>> TreeSeeds;
+    for (int32 i = 0; i < Trees.Num(); ++i)
+    {
+        TreeSeeds.Add(Seeds.RandHelper(MAX_int32));
+    }
+
+    ParallelFor(Trees.Num(), [this, Deadline, &TreeSeeds](int32 Index)
+    {
+        FMatch3MctsTree& Tree = Trees[Index];
+        if (!Tree.Advance(SearchBoard))
+        {
+            Tree.Reset(SearchBoard);
+        }
+        Tree.Search(Deadline, bCancelled, Settings, TreeSeeds[Index]);
+    });
+
+    // every tree expands the root with FindAllMoves on the same board, so moves line up
+    TArray<int32, TInlineAllocator<64>> Votes;
+    Votes.SetNumZeroed(Trees[0].NumRootMoves());
+    LastIterations = 0;
+    for (const FMatch3MctsTree& Tree : Trees)
+    {
+        LastIterations += Tree.GetIterations();
+        for (int32 i = 0; i < Votes.Num() && i < Tree.NumRootMoves(); ++i)
+        {
+            int32 CellA = 0;
+            int32 CellB = 0;
+            int32 Visits = 0;
+            Tree.GetRootMove(i, CellA, CellB, Visits);
+            Votes[i] += Visits;
+        }
+    }
+
+    int32 Best = INDEX_NONE;
+    for (int32 i = 0; i < Votes.Num(); ++i)
+    {
+        if (Best == INDEX_NONE || Votes[i] > Votes[Best])
+        {
+            Best = i;
+        }
+    }
+    if (Best != INDEX_NONE)
+    {
+        int32 Visits = 0;
+        Trees[0].GetRootMove(Best, DecisionA, DecisionB, Visits);
+    }
+}
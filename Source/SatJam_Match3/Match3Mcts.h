@@ -0,0 +1,153 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Tasks/Task.h"
+#include "Match3Board.h"
+
+struct FMatch3MctsSettings
+{
+    // thinking time per move
+    float TimeBudgetSeconds = 0.25f;
+
+    // independent trees searched in parallel, 0 for one per worker thread
+    int32 NumTrees = 0;
+
+    // boards per tree; when full, rollouts start from the leaves
+    int32 MaxNodes = 20000;
+
+    // random turns played after leaving the tree
+    int32 RolloutTurns = 3;
+
+    // UCB1 exploration, rewards are scaled to the best one seen
+    float Exploration = 1.0f;
+};
+
+// one search tree, searched by one worker at a time
+// nodes are boards; a swap out of a node leads to the boards its refills made in
+// simulation, refills come from random streams so the AI never reads the real one
+class FMatch3MctsTree
+{
+public:
+    // new tree rooted at Board
+    void Reset(const FMatch3Board& Board);
+
+    // move the root to the simulated board that matches Board (same colors after a
+    // real turn) and keep its subtree, false if no simulation produced it
+    bool Advance(const FMatch3Board& Board);
+
+    // iterate until Deadline (FPlatformTime::Seconds) or bCancelled
+    void Search(double Deadline, const TAtomic<bool>& bCancelled, const FMatch3MctsSettings& Settings, int32 Seed);
+
+    // root swaps in FindAllMoves order with their visits, valid after a search
+    int32 NumRootMoves() const;
+    void GetRootMove(int32 Index, int32& OutCellA, int32& OutCellB, int32& OutVisits) const;
+
+    int32 GetIterations() const { return Iterations; }
+
+private:
+    struct FNode
+    {
+        // INDEX_NONE until expanded
+        int32 FirstEdge = INDEX_NONE;
+        int32 NumEdges = 0;
+        int32 Visits = 0;
+    };
+
+    struct FEdge
+    {
+        int32 CellA = 0;
+        int32 CellB = 0;
+        int32 Visits = 0;
+        double TotalReward = 0.0;
+
+        // boards this swap led to, linked through FOutcome::Next
+        int32 FirstOutcome = INDEX_NONE;
+    };
+
+    struct FOutcome
+    {
+        uint64 Hash = 0;
+        int32 Node = INDEX_NONE;
+        int32 Next = INDEX_NONE;
+    };
+
+    // root is node 0, node i's colors are Cells[i * NumCells ...]
+    // outcomes are keyed by the board's Zobrist hash
+    TArray<FNode> Nodes;
+    TArray<FEdge> Edges;
+    TArray<FOutcome> Outcomes;
+    TArray<uint8> Cells;
+    int32 NumCells = 0;
+    uint64 RootHash = 0;
+    int32 MaxNodes = 0;
+    double MaxReward = 0.0;
+    int32 Iterations = 0;
+
+    // scratch, the simulated board and the current path
+    FMatch3Board Board;
+    FMatch3MoveList Moves;
+    FRandomStream Rand;
+    TArray<int32> PathNodes;
+    TArray<int32> PathEdges;
+    TArray<int32> PathPoints;
+
+    void RunIteration(const FMatch3MctsSettings& Settings);
+    void Expand(int32 Node);
+    int32 SelectEdge(int32 Node, float Exploration) const;
+
+    // play a swap with a random refill, false if the board is dead afterwards
+    bool PlayTurn(int32 CellA, int32 CellB, int32& OutPoints);
+    int32 Rollout(int32 Turns);
+
+    int32 FindOutcome(int32 Edge, uint64 Hash) const;
+    int32 AddNode(int32 Edge, uint64 Hash);
+    bool NodeMatches(int32 Node, const TArray<uint8>& InCells) const;
+
+    // keep only the subtree under NewRoot
+    void Rebase(int32 NewRoot);
+};
+
+// versus AI: Monte Carlo tree search over a copy of the board
+// each worker searches a tree of its own (root parallel), their root visits are
+// summed for the decision, so more cores mean more rollouts per move
+class SATJAM_MATCH3_API FMatch3MctsPlayer
+{
+public:
+    explicit FMatch3MctsPlayer(const FMatch3MctsSettings& InSettings);
+
+    // cancels a running search and waits for it
+    ~FMatch3MctsPlayer();
+
+    // think about a copy of Board on worker threads, returns at once
+    // the trees are kept when Board is a refill they simulated
+    void StartSearch(const FMatch3Board& Board);
+
+    bool IsSearching() const { return bSearching; }
+
+    // game thread: the chosen swap once the search is done, once per search
+    // false while searching or when the board has no move
+    bool TryGetDecision(int32& OutCellA, int32& OutCellB);
+
+    // iterations of the last search over all trees
+    int32 GetLastIterations() const { return LastIterations; }
+
+private:
+    FMatch3MctsSettings Settings;
+
+    // task side
+    TArray<FMatch3MctsTree> Trees;
+    FMatch3Board SearchBoard;
+    FRandomStream Seeds;
+    int32 DecisionA = INDEX_NONE;
+    int32 DecisionB = INDEX_NONE;
+    int32 LastIterations = 0;
+
+    UE::Tasks::FTask Task;
+    TAtomic<bool> bCancelled { false };
+    bool bSearching = false;
+
+    // runs on the task: search every tree until the budget is spent, then vote
+    void RunSearch();
+};
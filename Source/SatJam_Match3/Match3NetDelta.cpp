@@ -0,0 +1,102 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Match3NetDelta.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+namespace
+{
+    // snapshots are a few hundred bytes, anything far above is garbage
+    constexpr uint32 MaxTargetSize = 1 << 20;
+
+    FORCEINLINE uint8 BaseAt(TConstArrayView<uint8> Base, int32 Index)
+    {
+        return Index < Base.Num() ? Base[Index] : 0;
+    }
+}
+
+void Match3NetDelta::Encode(TConstArrayView<uint8> Base, TConstArrayView<uint8> Target, TArray<uint8>& OutDelta)
+{
+    OutDelta.Reset();
+    FMemoryWriter Writer(OutDelta);
+
+    const int32 Num = Target.Num();
+    uint32 TargetSize = Num;
+    Writer.SerializeIntPacked(TargetSize);
+
+    int32 i = 0;
+    while (i < Num)
+    {
+        const int32 UnchangedStart = i;
+        while (i < Num && BaseAt(Base, i) == Target[i])
+        {
+            ++i;
+        }
+
+        // changed bytes up to the next unchanged run worth a new pair
+        const int32 ChangedStart = i;
+        while (i < Num)
+        {
+            if (BaseAt(Base, i) != Target[i])
+            {
+                ++i;
+                continue;
+            }
+
+            int32 RunEnd = i;
+            while (RunEnd < Num && BaseAt(Base, RunEnd) == Target[RunEnd])
+            {
+                ++RunEnd;
+            }
+            if (RunEnd == Num || RunEnd - i >= MinUnchangedRun) break;
+            i = RunEnd;
+        }
+
+        uint32 Unchanged = ChangedStart - UnchangedStart;
+        uint32 Changed = i - ChangedStart;
+        Writer.SerializeIntPacked(Unchanged);
+        Writer.SerializeIntPacked(Changed);
+        for (int32 j = ChangedStart; j < i; ++j)
+        {
+            uint8 Xor = BaseAt(Base, j) ^ Target[j];
+            Writer << Xor;
+        }
+    }
+}
+
+
+bool Match3NetDelta::Decode(TConstArrayView<uint8> Base, TConstArrayView<uint8> Delta, TArray<uint8>& OutTarget)
+{
+    FMemoryReaderView Reader(Delta);
+
+    uint32 TargetSize = 0;
+    Reader.SerializeIntPacked(TargetSize);
+    if (Reader.IsError() || TargetSize > MaxTargetSize) return false;
+
+    OutTarget.SetNumUninitialized(TargetSize);
+
+    uint32 Pos = 0;
+    while (Pos < TargetSize)
+    {
+        uint32 Unchanged = 0;
+        uint32 Changed = 0;
+        Reader.SerializeIntPacked(Unchanged);
+        Reader.SerializeIntPacked(Changed);
+        if (Reader.IsError() || Unchanged > TargetSize - Pos || Changed > TargetSize - Pos - Unchanged) return false;
+        if (Unchanged + Changed == 0) return false;
+
+        for (uint32 End = Pos + Unchanged; Pos < End; ++Pos)
+        {
+            OutTarget[Pos] = BaseAt(Base, Pos);
+        }
+        for (uint32 End = Pos + Changed; Pos < End; ++Pos)
+        {
+            uint8 Xor = 0;
+            Reader << Xor;
+            OutTarget[Pos] = BaseAt(Base, Pos) ^ Xor;
+        }
+    }
+
+    return !Reader.IsError();
+}
@@ -0,0 +1,21 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// XOR/RLE delta between two byte buffers (packed board snapshots for replication)
+// layout: packed uint32 TargetSize, then pairs of
+//   packed uint32 Unchanged, packed uint32 Changed, Changed x uint8 (Base ^ Target)
+// until TargetSize bytes are covered; missing Base bytes count as zero, so an
+// empty Base gives a run-length coded full copy
+namespace Match3NetDelta
+{
+    // unchanged runs shorter than this stay inside the changed run, a pair costs 2 bytes
+    constexpr int32 MinUnchangedRun = 3;
+
+    SATJAM_MATCH3_API void Encode(TConstArrayView<uint8> Base, TConstArrayView<uint8> Target, TArray<uint8>& OutDelta);
+
+    // false on truncated or oversized data
+    SATJAM_MATCH3_API bool Decode(TConstArrayView<uint8> Base, TConstArrayView<uint8> Delta, TArray<uint8>& OutTarget);
+}
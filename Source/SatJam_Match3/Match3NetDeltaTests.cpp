@@ -0,0 +1,76 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Match3NetDelta.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    bool RoundTrips(TConstArrayView<uint8> Base, TConstArrayView<uint8> Target, TArray<uint8>& Delta)
+    {
+        Match3NetDelta::Encode(Base, Target, Delta);
+
+        TArray<uint8> Decoded;
+        return Match3NetDelta::Decode(Base, Delta, Decoded) && Decoded == TArray<uint8>(Target.GetData(), Target.Num());
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMatch3NetDeltaRoundTripTest, "SatJam.Match3.NetDelta.RoundTrip",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FMatch3NetDeltaRoundTripTest::RunTest(const FString& Parameters)
+{
+    FRandomStream Stream(35);
+    TArray<uint8> Delta;
+
+    // snapshot-sized buffers
+    TArray<uint8> Board;
+    Board.SetNumUninitialized(300);
+    for (uint8& Byte : Board)
+    {
+        Byte = static_cast<uint8>(Stream.RandRange(0, 255));
+    }
+
+    // an empty base is the full copy a client gets first
+    TestTrue(TEXT("empty base"), RoundTrips(TConstArrayView<uint8>(), Board, Delta));
+    TestTrue(TEXT("empty base, empty target"), RoundTrips(TConstArrayView<uint8>(), TConstArrayView<uint8>(), Delta));
+
+    // nothing changed: one pair covering everything
+    TestTrue(TEXT("identical"), RoundTrips(Board, Board, Delta));
+    TestTrue(TEXT("identical is small"), Delta.Num() <= 8);
+
+    for (int32 i = 0; i < 500; ++i)
+    {
+        // a few scattered or clustered changes, like a turn's clears and falls
+        TArray<uint8> Target = Board;
+        const int32 NumChanges = Stream.RandRange(1, i % 4 == 0 ? Target.Num() : 12);
+        for (int32 j = 0; j < NumChanges; ++j)
+        {
+            Target[Stream.RandHelper(Target.Num())] ^= static_cast<uint8>(Stream.RandRange(1, 255));
+        }
+
+        // sizes change when a board is resized or the header grows
+        if (i % 7 == 0)
+        {
+            Target.SetNum(Stream.RandRange(0, Board.Num() + 40));
+        }
+
+        if (!TestTrue(FString::Printf(TEXT("random diff %d"), i), RoundTrips(Board, Target, Delta))) break;
+    }
+
+    // truncated deltas fail instead of reading past the end
+    TArray<uint8> Target = Board;
+    Target[10] ^= 1;
+    Target[200] ^= 1;
+    Match3NetDelta::Encode(Board, Target, Delta);
+    TArray<uint8> Decoded;
+    for (int32 Num = 0; Num < Delta.Num(); ++Num)
+    {
+        TestFalse(TEXT("truncated delta"), Match3NetDelta::Decode(Board, TConstArrayView<uint8>(Delta.GetData(), Num), Decoded));
+    }
+    return true;
+}
+
+#endif
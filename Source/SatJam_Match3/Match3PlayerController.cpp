@@ -4,68 +4,337 @@
 #include "Match3PlayerController.h"
 #include "Match3Grid.h"
 #include "Engine/World.h"
+#include "Engine/LocalPlayer.h"
 #include "Kismet/GameplayStatics.h"
 #include "DrawDebugHelpers.h"
+#include "EnhancedInputComponent.h"
+#include "EnhancedInputSubsystems.h"
+#include "InputAction.h"
+#include "InputMappingContext.h"
+#include "Framework/Application/SlateApplication.h"
 
 void AMatch3PlayerController::BeginPlay()
 {
     Super::BeginPlay();
 
+    FindGridActor();
+
+    // a remote client starts from the current board
+    if (HasAuthority() && !IsLocalController() && GridActor)
+    {
+        GridActor->SendBoardTo(this);
+    }
+
+    if (SwapMappingContext)
+    {
+        if (UEnhancedInputLocalPlayerSubsystem* Subsystem = ULocalPlayer::GetSubsystem<UEnhancedInputLocalPlayerSubsystem>(GetLocalPlayer()))
+        {
+            Subsystem->AddMappingContext(SwapMappingContext, 0);
+        }
+    }
+}
+
+void AMatch3PlayerController::FindGridActor()
+{
     // Find the grid actor in the level
     TArray<AActor*> Found;
     UGameplayStatics::GetAllActorsOfClass(GetWorld(), AMatch3Grid::StaticClass(), Found);
     if (Found.Num() > 0)
     {
-        GridActor = Cast<AMatch3Grid>(Found[0]);
+        SetGridActor(Cast<AMatch3Grid>(Found[0]));
     }
 }
 
+void AMatch3PlayerController::SetGridActor(AMatch3Grid* NewGrid)
+{
+    if (GridActor)
+    {
+        GridActor->OnSwapChecked.RemoveDynamic(this, &AMatch3PlayerController::OnGridSwapChecked);
+    }
+    GridActor = NewGrid;
+    PendingSwapA = PendingSwapB = INDEX_NONE;
+    if (GridActor)
+    {
+        GridActor->OnSwapChecked.AddUniqueDynamic(this, &AMatch3PlayerController::OnGridSwapChecked);
+    }
+}
+
+void AMatch3PlayerController::OnGridSwapChecked(int32 CellA, int32 CellB, bool bAccepted)
+{
+    ResolvePendingSwap(FMath::Min(CellA, CellB), FMath::Max(CellA, CellB), bAccepted);
+}
+
+void AMatch3PlayerController::ResolvePendingSwap(int32 CellA, int32 CellB, bool bAccepted)
+{
+    if (CellA != PendingSwapA || CellB != PendingSwapB) return;
+    PendingSwapA = PendingSwapB = INDEX_NONE;
+    if (!bAccepted) return;
+
+    const double AcceptMs = (FPlatformTime::Seconds() - PendingReleaseTime) * 1000.0;
+    ++DragStats.AcceptedSwaps;
+    DragStats.TotalAcceptMs += AcceptMs;
+    DragStats.MaxAcceptMs = FMath::Max(DragStats.MaxAcceptMs, AcceptMs);
+}
+
+void AMatch3PlayerController::UseGridOf(AMatchTile* Tile)
+{
+    // with several grids in the level, input goes to the one owning the tile
+    AMatch3Grid* TileGrid = Cast<AMatch3Grid>(Tile->GetOwner());
+    if (TileGrid && TileGrid != GridActor)
+    {
+        SetGridActor(TileGrid);
+        SelectedCell = FIntPoint(INDEX_NONE, INDEX_NONE);
+    }
+}
+
+void AMatch3PlayerController::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+    if (DragStats.Swaps > 0)
+    {
+        UE_LOG(LogTemp, Log, TEXT("Drag swaps: %d (taps %d), avg gesture %.1f ms, release to accepted swap avg %.3f ms max %.3f ms over %d accepted"),
+            DragStats.Swaps, DragStats.Taps,
+            DragStats.TotalGestureMs / DragStats.Swaps,
+            DragStats.AcceptedSwaps > 0 ? DragStats.TotalAcceptMs / DragStats.AcceptedSwaps : 0.0, DragStats.MaxAcceptMs,
+            DragStats.AcceptedSwaps);
+    }
+    SetGridActor(nullptr);
+
+    Super::EndPlay(EndPlayReason);
+}
+
 void AMatch3PlayerController::SetupInputComponent()
 {
     Super::SetupInputComponent();
-
-    InputComponent->BindAction("LeftClick", IE_Pressed, this, &AMatch3PlayerController::OnLeftClick);
     bShowMouseCursor = true;
+
+    UEnhancedInputComponent* EnhancedInput = Cast<UEnhancedInputComponent>(InputComponent);
+    if (!EnhancedInput)
+    {
+        InputComponent->BindAction("LeftClick", IE_Pressed, this, &AMatch3PlayerController::OnLeftClick);
+        return;
+    }
+
+    // default press action on left mouse and first touch
+    if (!PressAction)
+    {
+        PressAction = NewObject<UInputAction>(this, TEXT("Match3Press"));
+        PressAction->ValueType = EInputActionValueType::Boolean;
+    }
+    if (!SwapMappingContext)
+    {
+        SwapMappingContext = NewObject<UInputMappingContext>(this, TEXT("Match3Swap"));
+        SwapMappingContext->MapKey(PressAction, EKeys::LeftMouseButton);
+        SwapMappingContext->MapKey(PressAction, EKeys::TouchKeys[0]);
+    }
+
+    // Triggered runs every frame while held and only samples the pointer
+    EnhancedInput->BindAction(PressAction, ETriggerEvent::Started, this, &AMatch3PlayerController::OnPressStarted);
+    EnhancedInput->BindAction(PressAction, ETriggerEvent::Triggered, this, &AMatch3PlayerController::OnPressHeld);
+    EnhancedInput->BindAction(PressAction, ETriggerEvent::Completed, this, &AMatch3PlayerController::OnPressReleased);
+    EnhancedInput->BindAction(PressAction, ETriggerEvent::Canceled, this, &AMatch3PlayerController::OnPressReleased);
 }
 
 void AMatch3PlayerController::OnLeftClick()
 {
-    if (!GridActor || GridActor->bInputLocked) return;
+    // clicks during a cascade are still taken, the grid queues the swap
+    if (!GridActor) return;
 
     AMatchTile* HitTile = GetTileUnderCursor();
     if (!HitTile) return;
 
-    if (!SelectedTile)
+    UseGridOf(HitTile);
+    SelectCell(FIntPoint(HitTile->Row, HitTile->Col));
+}
+
+void AMatch3PlayerController::OnPressStarted(const FInputActionValue& Value)
+{
+    bPressing = false;
+    if (!GridActor) return;
+
+    // the only trace of the gesture
+    AMatchTile* HitTile = GetTileUnderCursor();
+    if (!HitTile || !GetPointerPosition(PressPosition)) return;
+
+    UseGridOf(HitTile);
+
+    PressCell = FIntPoint(HitTile->Row, HitTile->Col);
+    LastPosition = PressPosition;
+    PressTime = FPlatformTime::Seconds();
+
+    // project the cell and its +Col / +Row neighbors once, release only needs a dot product
+    const FVector Center = AMatchTile::GetWorldLocationForGrid(PressCell.X, PressCell.Y, GridActor->CellSize, GridActor->GridOrigin);
+    const FVector NextCol = AMatchTile::GetWorldLocationForGrid(PressCell.X, PressCell.Y + 1, GridActor->CellSize, GridActor->GridOrigin);
+    const FVector NextRow = AMatchTile::GetWorldLocationForGrid(PressCell.X + 1, PressCell.Y, GridActor->CellSize, GridActor->GridOrigin);
+
+    FVector2D CenterScreen, ColScreen, RowScreen;
+    if (!ProjectWorldLocationToScreen(Center, CenterScreen) ||
+        !ProjectWorldLocationToScreen(NextCol, ColScreen) ||
+        !ProjectWorldLocationToScreen(NextRow, RowScreen))
     {
-        // pick first tile
-        SelectedTile = HitTile;
+        return;
+    }
+
+    ColAxis = (ColScreen - CenterScreen).GetSafeNormal();
+    RowAxis = (RowScreen - CenterScreen).GetSafeNormal();
+    bPressing = true;
+}
+
+void AMatch3PlayerController::OnPressHeld(const FInputActionValue& Value)
+{
+    if (!bPressing) return;
+
+    GetPointerPosition(LastPosition);
+}
+
+void AMatch3PlayerController::OnPressReleased(const FInputActionValue& Value)
+{
+    if (!bPressing || !GridActor) return;
+    bPressing = false;
+
+    // Slate stamps the release when it processes the platform event, before input
+    // reaches this handler
+    const double ReleaseTime = FSlateApplication::IsInitialized()
+        ? FSlateApplication::Get().GetLastUserInteractionTime() : FPlatformTime::Seconds();
+    GetPointerPosition(LastPosition);
+
+    const FVector2D Delta = LastPosition - PressPosition;
+    if (Delta.Size() < DragThreshold)
+    {
+        // tap, keep the two-click selection
+        ++DragStats.Taps;
+        SelectCell(PressCell);
+        return;
+    }
+
+    // the axis the drag follows most picks the neighbor
+    const float AlongCol = FVector2D::DotProduct(Delta, ColAxis);
+    const float AlongRow = FVector2D::DotProduct(Delta, RowAxis);
+    FIntPoint Target = PressCell;
+    if (FMath::Abs(AlongCol) >= FMath::Abs(AlongRow))
+    {
+        Target.Y += AlongCol > 0.f ? 1 : -1;
     }
     else
     {
-        // if same tile, deselect
-        if (SelectedTile == HitTile)
-        {
-            SelectedTile = nullptr;
-            return;
-        }
+        Target.X += AlongRow > 0.f ? 1 : -1;
+    }
 
-        // check adjacency
-        int dR = FMath::Abs(SelectedTile->Row - HitTile->Row);
-        int dC = FMath::Abs(SelectedTile->Col - HitTile->Col);
-        if ((dR + dC) == 1)
-        {
-            GridActor->AttemptSwap(SelectedTile, HitTile);
-        }
+    SelectedCell = FIntPoint(INDEX_NONE, INDEX_NONE);
+    if (!GridActor->IsInside(Target.X, Target.Y)) return;
+
+    ++DragStats.Swaps;
+    DragStats.TotalGestureMs += (ReleaseTime - PressTime) * 1000.0;
+
+    // timed until the grid accepts it, which may be this call or a later update
+    const int32 CellA = PressCell.X * GridActor->Cols + PressCell.Y;
+    const int32 CellB = Target.X * GridActor->Cols + Target.Y;
+    PendingSwapA = FMath::Min(CellA, CellB);
+    PendingSwapB = FMath::Max(CellA, CellB);
+    PendingReleaseTime = ReleaseTime;
+    SendSwap(CellA, CellB);
+}
+
+void AMatch3PlayerController::SelectCell(const FIntPoint& Cell)
+{
+    if (SelectedCell.X == INDEX_NONE)
+    {
+        // pick first tile
+        SelectedCell = Cell;
+        return;
+    }
+
+    // if same tile, deselect
+    if (SelectedCell == Cell)
+    {
+        SelectedCell = FIntPoint(INDEX_NONE, INDEX_NONE);
+        return;
+    }
+
+    // check adjacency
+    int dR = FMath::Abs(SelectedCell.X - Cell.X);
+    int dC = FMath::Abs(SelectedCell.Y - Cell.Y);
+    if ((dR + dC) == 1)
+    {
+        SendSwap(SelectedCell.X * GridActor->Cols + SelectedCell.Y, Cell.X * GridActor->Cols + Cell.Y);
+    }
+
+    SelectedCell = FIntPoint(INDEX_NONE, INDEX_NONE);
+}
 
-        SelectedTile = nullptr;
+void AMatch3PlayerController::SendSwap(int32 CellA, int32 CellB)
+{
+    // clients only send the intent, the server's turn comes back through ClientReceiveTurn
+    if (GetNetMode() == NM_Client)
+    {
+        ServerRequestSwap(CellA, CellB);
+        return;
     }
+
+    GridActor->RequestSwap(CellA, CellB);
+}
+
+void AMatch3PlayerController::ClientReceiveTurn_Implementation(const FMatch3NetTurn& Turn)
+{
+    // the first board can arrive before our BeginPlay
+    if (!GridActor)
+    {
+        FindGridActor();
+    }
+    if (!GridActor) return;
+
+    // our dragged swap came back from the server
+    if (Turn.Swap != INDEX_NONE && PendingSwapA != INDEX_NONE)
+    {
+        const int32 CellA = Turn.Swap >> 1;
+        const int32 CellB = CellA + ((Turn.Swap & 1) ? GridActor->Cols : 1);
+        ResolvePendingSwap(CellA, CellB, true);
+    }
+
+    ServerAckTurn(GridActor->ReceiveNetTurn(Turn) ? Turn.Sequence : INDEX_NONE);
+}
+
+void AMatch3PlayerController::ServerAckTurn_Implementation(int32 Sequence)
+{
+    // reliable and ordered, so the newest ack is the last one
+    AckedSequence = Sequence;
+}
+
+void AMatch3PlayerController::ServerRequestSwap_Implementation(int32 CellA, int32 CellB)
+{
+    if (!GridActor) return;
+
+    GridActor->RequestSwap(CellA, CellB);
 }
 
 AMatchTile* AMatch3PlayerController::GetTileUnderCursor() const
 {
     FHitResult Hit;
     bool bHit = GetHitResultUnderCursorByChannel(ETraceTypeQuery::TraceTypeQuery1, true, Hit);
+    if (!bHit)
+    {
+        // touch has no cursor
+        bHit = GetHitResultUnderFingerByChannel(ETouchIndex::Touch1, ETraceTypeQuery::TraceTypeQuery1, true, Hit);
+    }
     if (!bHit) return nullptr;
 
     return Cast<AMatchTile>(Hit.GetActor());
 }
+
+bool AMatch3PlayerController::GetPointerPosition(FVector2D& OutPosition) const
+{
+    float X = 0.f, Y = 0.f;
+    if (GetMousePosition(X, Y))
+    {
+        OutPosition = FVector2D(X, Y);
+        return true;
+    }
+
+    bool bPressed = false;
+    GetInputTouchState(ETouchIndex::Touch1, X, Y, bPressed);
+    if (bPressed)
+    {
+        OutPosition = FVector2D(X, Y);
+        return true;
+    }
+    return false;
+}
@@ -5,9 +5,28 @@
 #include "CoreMinimal.h"
 #include "GameFramework/PlayerController.h"
 #include "MatchTile.h"
+#include "Match3Grid.h"
 #include "Match3PlayerController.generated.h"
 
-class AMatch3Grid;
+class UInputAction;
+class UInputMappingContext;
+struct FInputActionValue;
+
+// press-drag-release timings, logged on EndPlay
+struct FMatch3DragStats
+{
+    int32 Swaps = 0;
+    int32 Taps = 0;
+
+    // press to release
+    double TotalGestureMs = 0.0;
+
+    // release input event to the grid accepting the swap (OnSwapChecked, or the
+    // server's turn on a client); rejected swaps are not counted
+    int32 AcceptedSwaps = 0;
+    double TotalAcceptMs = 0.0;
+    double MaxAcceptMs = 0.0;
+};
 
 UCLASS()
 class SATJAM_MATCH3_API AMatch3PlayerController : public APlayerController
@@ -16,20 +35,93 @@ class SATJAM_MATCH3_API AMatch3PlayerController : public APlayerController
 
 public:
     virtual void BeginPlay() override;
+    virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
     virtual void SetupInputComponent() override;
 
+    // press action (bool), created with a left mouse / touch mapping if left empty
+    UPROPERTY(EditAnywhere, Category = "Input")
+    TObjectPtr<UInputAction> PressAction;
+
+    UPROPERTY(EditAnywhere, Category = "Input")
+    TObjectPtr<UInputMappingContext> SwapMappingContext;
+
+    // screen distance in pixels a drag needs before it counts as a swap, shorter is a tap
+    UPROPERTY(EditAnywhere, Category = "Input")
+    float DragThreshold = 20.f;
+
+    // server -> owning client: one resolved turn
+    UFUNCTION(Client, Reliable)
+    void ClientReceiveTurn(const FMatch3NetTurn& Turn);
+
+    // client -> server: the newest board the client holds, INDEX_NONE asks for a full one
+    UFUNCTION(Server, Reliable)
+    void ServerAckTurn(int32 Sequence);
+
+    // client -> server: swap intent, resolved on the server's board
+    UFUNCTION(Server, Reliable)
+    void ServerRequestSwap(int32 CellA, int32 CellB);
+
+    // server side: delta base for this client's next turn
+    int32 GetAckedSequence() const { return AckedSequence; }
+
 private:
-    // current selected tile
-    AMatchTile* SelectedTile = nullptr;
+    // current selected cell (Row, Col), kept as a position so a selection
+    // made during a cascade survives its tile being cleared
+    FIntPoint SelectedCell = FIntPoint(INDEX_NONE, INDEX_NONE);
 
     // convenience cached pointer
     UPROPERTY()
     AMatch3Grid* GridActor = nullptr;
 
+    // gesture state, filled on the press frame
+    bool bPressing = false;
+    FIntPoint PressCell = FIntPoint(INDEX_NONE, INDEX_NONE);
+    FVector2D PressPosition = FVector2D::ZeroVector;
+    FVector2D LastPosition = FVector2D::ZeroVector;
+
+    // screen direction of +Col and +Row at the pressed cell
+    FVector2D ColAxis = FVector2D::ZeroVector;
+    FVector2D RowAxis = FVector2D::ZeroVector;
+    double PressTime = 0.0;
+
+    FMatch3DragStats DragStats;
+
+    // dragged swap waiting for the grid's answer, CellA < CellB
+    int32 PendingSwapA = INDEX_NONE;
+    int32 PendingSwapB = INDEX_NONE;
+    double PendingReleaseTime = 0.0;
+
+    int32 AckedSequence = INDEX_NONE;
+
+    void FindGridActor();
+
+    // switch to the grid that spawned Tile
+    void UseGridOf(AMatchTile* Tile);
+
+    // follow OnSwapChecked of GridActor, nullptr unbinds
+    void SetGridActor(AMatch3Grid* NewGrid);
+
+    UFUNCTION()
+    void OnGridSwapChecked(int32 CellA, int32 CellB, bool bAccepted);
+
+    // the pending drag swap was accepted or rejected
+    void ResolvePendingSwap(int32 CellA, int32 CellB, bool bAccepted);
+
     // input handlers
     void OnLeftClick();
+    void OnPressStarted(const FInputActionValue& Value);
+    void OnPressHeld(const FInputActionValue& Value);
+    void OnPressReleased(const FInputActionValue& Value);
+
+    // two-click selection, also used for taps
+    void SelectCell(const FIntPoint& Cell);
+
+    // to the grid, or to the server on a client
+    void SendSwap(int32 CellA, int32 CellB);
 
     // helper to find tile under cursor
     AMatchTile* GetTileUnderCursor() const;
-};
 
+    // mouse or first touch position in screen space
+    bool GetPointerPosition(FVector2D& OutPosition) const;
+};
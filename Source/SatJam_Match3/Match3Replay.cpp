@@ -0,0 +1,229 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Match3Replay.h"
+#include "Misc/FileHelper.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+void FMatch3Replay::Begin(const FMatch3Board& Board, int32 InSeed)
+{
+    Rows = Board.Rows;
+    Cols = Board.Cols;
+    NumColors = Board.NumColors;
+    Seed = InSeed;
+    ScoreRules = Board.Scoring.Rules;
+    MaxCascadeDepth = Board.MaxCascadeDepth;
+    bShuffleDeadBoards = Board.bShuffleDeadBoards;
+    CellKinds.Reset();
+    if (Board.Shape)
+    {
+        CellKinds = Board.Shape->Kinds;
+    }
+    Swaps.Reset();
+    FinalScore = 0;
+    FinalCells.Reset();
+}
+
+
+void FMatch3Replay::RecordSwap(int32 CellA, int32 CellB)
+{
+    const int32 First = FMath::Min(CellA, CellB);
+    const bool bVertical = FMath::Abs(CellA - CellB) != 1;
+    Swaps.Add((static_cast<uint32>(First) << 1) | (bVertical ? 1u : 0u));
+}
+
+
+void FMatch3Replay::RecordReseed(int32 RegenSeed)
+{
+    Swaps.Add(ReseedMarker);
+    Swaps.Add(static_cast<uint32>(RegenSeed));
+}
+
+
+void FMatch3Replay::Finish(const FMatch3Board& Board)
+{
+    FinalScore = Board.Score;
+    FinalCells = Board.Cells;
+}
+
+
+bool FMatch3Replay::Serialize(FArchive& Ar)
+{
+    uint32 FileMagic = Magic;
+    uint16 Version = CurrentVersion;
+    Ar << FileMagic;
+    Ar << Version;
+    if (FileMagic != Magic || Version > CurrentVersion)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("Replay: bad header (magic %08x, version %d)"), FileMagic, Version);
+        return false;
+    }
+
+    uint16 Rows16 = static_cast<uint16>(Rows);
+    uint16 Cols16 = static_cast<uint16>(Cols);
+    uint8 NumColors8 = static_cast<uint8>(NumColors);
+    Ar << Rows16;
+    Ar << Cols16;
+    Ar << NumColors8;
+    Ar << Seed;
+    Rows = Rows16;
+    Cols = Cols16;
+    NumColors = NumColors8;
+    if (!FMatch3Board::IsSupportedSize(Rows, Cols) || NumColors < FMatch3Board::MinColors || NumColors > FMatch3Board::MaxColors)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("Replay: unsupported board %dx%d with %d colors"), Rows, Cols, NumColors);
+        return false;
+    }
+
+    if (Version >= 2)
+    {
+        Ar << ScoreRules.PointsPerClear;
+        Ar << ScoreRules.CascadeBonusPercent;
+        for (int32& Bonus : ScoreRules.ShapeBonusPercent)
+        {
+            Ar << Bonus;
+        }
+    }
+    else
+    {
+        // v1 sessions were played before the timer path awarded points
+        ScoreRules = FMatch3ScoreRules();
+        ScoreRules.PointsPerClear = 0;
+    }
+
+    if (Version >= 3)
+    {
+        Ar << MaxCascadeDepth;
+    }
+
+    uint8 bShuffle = bShuffleDeadBoards ? 1 : 0;
+    if (Version >= 5)
+    {
+        Ar << bShuffle;
+    }
+    else
+    {
+        bShuffle = 0;
+    }
+    bShuffleDeadBoards = bShuffle != 0;
+
+    uint8 bShaped = CellKinds.Num() > 0 ? 1 : 0;
+    if (Version >= 6)
+    {
+        Ar << bShaped;
+    }
+    else
+    {
+        bShaped = 0;
+    }
+    if (Ar.IsLoading())
+    {
+        CellKinds.SetNumZeroed(bShaped ? Rows * Cols : 0);
+    }
+    for (EMatch3CellKind& Kind : CellKinds)
+    {
+        uint8 KindByte = static_cast<uint8>(Kind);
+        Ar << KindByte;
+        if (KindByte > static_cast<uint8>(EMatch3CellKind::Blocked)) return false;
+        Kind = static_cast<EMatch3CellKind>(KindByte);
+    }
+
+    uint32 NumSwaps = Swaps.Num();
+    Ar.SerializeIntPacked(NumSwaps);
+    if (Ar.IsLoading())
+    {
+        // every packed swap is at least one byte
+        if (Ar.IsError() || NumSwaps > static_cast<uint32>(Ar.TotalSize() - Ar.Tell()))
+        {
+            return false;
+        }
+        Swaps.SetNumUninitialized(NumSwaps);
+    }
+    for (uint32& Swap : Swaps)
+    {
+        Ar.SerializeIntPacked(Swap);
+    }
+
+    Ar << FinalScore;
+    if (Ar.IsLoading())
+    {
+        FinalCells.SetNumUninitialized(Rows * Cols);
+    }
+    Ar.Serialize(FinalCells.GetData(), FinalCells.Num());
+
+    return !Ar.IsError();
+}
+
+
+bool FMatch3Replay::SaveToFile(const FString& Filename)
+{
+    TArray<uint8> Data;
+    FMemoryWriter Writer(Data);
+    if (!Serialize(Writer)) return false;
+    return FFileHelper::SaveArrayToFile(Data, *Filename);
+}
+
+
+bool FMatch3Replay::LoadFromFile(const FString& Filename)
+{
+    TArray<uint8> Data;
+    if (!FFileHelper::LoadFileToArray(Data, *Filename)) return false;
+    FMemoryReader Reader(Data);
+    return Serialize(Reader);
+}
+
+
+bool FMatch3Replay::Play(FMatch3Board& OutBoard) const
+{
+    // same start as AMatch3Grid::BeginPlay
+    OutBoard.Init(Rows, Cols, Seed);
+    OutBoard.SetNumColors(NumColors);
+    OutBoard.Scoring.Rules = ScoreRules;
+    OutBoard.MaxCascadeDepth = MaxCascadeDepth;
+    OutBoard.bShuffleDeadBoards = bShuffleDeadBoards;
+    if (CellKinds.Num() > 0)
+    {
+        OutBoard.SetShape(FMatch3BoardShape::Make(Rows, Cols, CellKinds));
+    }
+
+    // regenerate from the recorded seed if there is one, else from the board's stream
+    int32 Next = 0;
+    auto RegenerateBoard = [this, &OutBoard, &Next]()
+    {
+        if (Next + 1 < Swaps.Num() && Swaps[Next] == ReseedMarker)
+        {
+            OutBoard.RegenerateFromSeed(static_cast<int32>(Swaps[Next + 1]));
+            Next += 2;
+            return;
+        }
+        OutBoard.Regenerate();
+    };
+
+    RegenerateBoard();
+
+    while (Next < Swaps.Num())
+    {
+        const uint32 Swap = Swaps[Next++];
+        if (Swap == ReseedMarker)
+        {
+            // regenerated outside a turn
+            if (Next < Swaps.Num())
+            {
+                OutBoard.RegenerateFromSeed(static_cast<int32>(Swaps[Next++]));
+            }
+            continue;
+        }
+
+        const int32 CellA = static_cast<int32>(Swap >> 1);
+        const int32 CellB = CellA + ((Swap & 1u) ? Cols : 1);
+
+        int32 Depth = 0;
+        if (OutBoard.TrySwap(CellA, CellB) && OutBoard.ResolveCascade(Depth) && !OutBoard.TryShuffleDeadBoard())
+        {
+            RegenerateBoard();
+        }
+    }
+
+    return OutBoard.Score == FinalScore && OutBoard.Cells == FinalCells;
+}
@@ -0,0 +1,70 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Match3Board.h"
+
+// recorded session: seed plus the stream of swaps the player attempted
+// playback runs the swaps through FMatch3Board as fast as possible (no actors,
+// no ClearDelay timers) and checks the final board and score
+//
+// file layout (little endian, versioned):
+//   uint32 Magic, uint16 Version, uint16 Rows, uint16 Cols, uint8 NumColors, int32 Seed
+//   (v2) int32 PointsPerClear, int32 CascadeBonusPercent, 7 x int32 ShapeBonusPercent
+//   (v3) int32 MaxCascadeDepth
+//   (v5) uint8 bShuffleDeadBoards
+//   (v6) uint8 bShaped, then Rows * Cols x uint8 EMatch3CellKind if set
+//   packed uint32 NumSwaps, NumSwaps x packed uint32 (Cell << 1 | bVertical)
+//   (v4) ReseedMarker followed by a seed: the board was regenerated from that seed
+//        (FMatch3Board::RegenerateFromSeed), first entry for the initial board
+//   int32 FinalScore, Rows * Cols x uint8 final colors
+struct SATJAM_MATCH3_API FMatch3Replay
+{
+    static constexpr uint32 Magic = 0x5052334D; // "M3RP"
+    static constexpr uint16 CurrentVersion = 6;
+
+    // never a valid swap, cell indices stay far below 2^31
+    static constexpr uint32 ReseedMarker = 0xFFFFFFFFu;
+
+    int32 Rows = 0;
+    int32 Cols = 0;
+    int32 NumColors = FMatch3Board::DefaultNumColors;
+    int32 Seed = 0;
+
+    // scoring and cascade cap the session was played with
+    FMatch3ScoreRules ScoreRules;
+    int32 MaxCascadeDepth = 100;
+    bool bShuffleDeadBoards = false;
+
+    // holes and blocked cells of the level, empty for a full rectangle
+    TArray<EMatch3CellKind> CellKinds;
+
+    // one entry per swap: lower cell index of the pair, shifted left, low bit set for vertical
+    // plus reseed pairs
+    TArray<uint32> Swaps;
+
+    int32 FinalScore = 0;
+    TArray<uint8> FinalCells;
+
+    // start a new recording for a board initialized from Seed
+    void Begin(const FMatch3Board& Board, int32 InSeed);
+
+    // record an adjacent swap attempt, accepted or not
+    void RecordSwap(int32 CellA, int32 CellB);
+
+    // record a regenerate that used RegenerateFromSeed
+    void RecordReseed(int32 RegenSeed);
+
+    // capture the expected result
+    void Finish(const FMatch3Board& Board);
+
+    // returns false on a bad header or truncated data
+    bool Serialize(FArchive& Ar);
+
+    bool SaveToFile(const FString& Filename);
+    bool LoadFromFile(const FString& Filename);
+
+    // replay from the seed into OutBoard, true if the final board and score match
+    bool Play(FMatch3Board& OutBoard) const;
+};
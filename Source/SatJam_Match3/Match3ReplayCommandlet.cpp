@@ -0,0 +1,75 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Match3ReplayCommandlet.h"
+#include "Match3Replay.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/Paths.h"
+
+UMatch3ReplayCommandlet::UMatch3ReplayCommandlet()
+{
+    IsClient = false;
+    IsEditor = false;
+    IsServer = false;
+    LogToConsole = true;
+}
+
+int32 UMatch3ReplayCommandlet::Main(const FString& Params)
+{
+    FString ReplayPath;
+    if (!FParse::Value(*Params, TEXT("replays="), ReplayPath))
+    {
+        UE_LOG(LogTemp, Error, TEXT("Match3Replay: missing -replays=<file or directory>"));
+        return 1;
+    }
+
+    // collect files
+    TArray<FString> Files;
+    if (IFileManager::Get().DirectoryExists(*ReplayPath))
+    {
+        IFileManager::Get().FindFiles(Files, *FPaths::Combine(ReplayPath, TEXT("*.m3replay")), true, false);
+        for (FString& File : Files)
+        {
+            File = FPaths::Combine(ReplayPath, File);
+        }
+    }
+    else
+    {
+        Files.Add(ReplayPath);
+    }
+
+    // load everything first so the timing only covers playback
+    TArray<FMatch3Replay> Replays;
+    Replays.Reserve(Files.Num());
+    for (const FString& File : Files)
+    {
+        FMatch3Replay& Replay = Replays.AddDefaulted_GetRef();
+        if (!Replay.LoadFromFile(File))
+        {
+            UE_LOG(LogTemp, Error, TEXT("Match3Replay: failed to load %s"), *File);
+            return 1;
+        }
+    }
+
+    int32 Failed = 0;
+    int64 TotalSwaps = 0;
+    FMatch3Board Board;
+
+    const double StartTime = FPlatformTime::Seconds();
+    for (int32 i = 0; i < Replays.Num(); ++i)
+    {
+        if (!Replays[i].Play(Board))
+        {
+            UE_LOG(LogTemp, Error, TEXT("Match3Replay: %s diverged (score %d, expected %d)"), *Files[i], Board.Score, Replays[i].FinalScore);
+            Failed++;
+        }
+        TotalSwaps += Replays[i].Swaps.Num();
+    }
+    const double Elapsed = FPlatformTime::Seconds() - StartTime;
+
+    UE_LOG(LogTemp, Display, TEXT("Match3Replay: %d replays, %lld swaps, %d failed in %.3f s (%.0f swaps/s)"),
+        Replays.Num(), TotalSwaps, Failed, Elapsed, Elapsed > 0.0 ? TotalSwaps / Elapsed : 0.0);
+
+    return Failed > 0 ? 1 : 0;
+}
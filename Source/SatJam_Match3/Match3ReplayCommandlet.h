@@ -0,0 +1,20 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "Match3ReplayCommandlet.generated.h"
+
+// replays recorded sessions headless and checks their final board and score
+// usage: UnrealEditor-Cmd SatJam_Match3.uproject -run=Match3Replay -replays=<file or directory> -nullrhi
+UCLASS()
+class SATJAM_MATCH3_API UMatch3ReplayCommandlet : public UCommandlet
+{
+    GENERATED_BODY()
+
+public:
+    UMatch3ReplayCommandlet();
+
+    virtual int32 Main(const FString& Params) override;
+};
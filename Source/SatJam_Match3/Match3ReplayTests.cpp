@@ -0,0 +1,99 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Match3Replay.h"
+#include "Misc/AutomationTest.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMatch3ReplayRoundTripTest, "SatJam.Match3.Replay.RoundTrip",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FMatch3ReplayRoundTripTest::RunTest(const FString& Parameters)
+{
+    for (int32 Seed = 1; Seed <= 8; ++Seed)
+    {
+        // record a session the way AMatch3Grid does, random swaps included
+        FMatch3Board Board;
+        Board.Init(8, 8, Seed);
+        Board.SetNumColors(3 + Seed % 6);
+        Board.bShuffleDeadBoards = (Seed & 1) != 0;
+
+        FMatch3Replay Recorded;
+        Recorded.Begin(Board, Seed);
+        Board.Regenerate();
+
+        FRandomStream Swaps(Seed * 31);
+        for (int32 i = 0; i < 200; ++i)
+        {
+            const int32 CellA = Swaps.RandHelper(Board.Num());
+            const int32 CellB = Swaps.RandBool() ? CellA + 1 : CellA + Board.Cols;
+            if (!Board.AreAdjacent(CellA, CellB)) continue;
+
+            Recorded.RecordSwap(CellA, CellB);
+            int32 Depth = 0;
+            if (Board.TrySwap(CellA, CellB) && Board.ResolveCascade(Depth) && !Board.TryShuffleDeadBoard())
+            {
+                Board.Regenerate();
+            }
+        }
+        Recorded.Finish(Board);
+
+        TArray<uint8> Data;
+        FMemoryWriter Writer(Data);
+        TestTrue(TEXT("replay serializes"), Recorded.Serialize(Writer));
+
+        FMatch3Replay Loaded;
+        FMemoryReader Reader(Data);
+        if (!TestTrue(TEXT("replay loads"), Loaded.Serialize(Reader))) continue;
+        TestEqual(TEXT("colors survive the file"), Loaded.NumColors, Recorded.NumColors);
+
+        // playback is deterministic: same final colors and score as the live session
+        FMatch3Board Played;
+        TestTrue(TEXT("playback matches the recording"), Loaded.Play(Played));
+        TestTrue(TEXT("final cells"), Played.Cells == Board.Cells);
+        TestEqual(TEXT("final score"), Played.Score, Board.Score);
+    }
+    return true;
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMatch3ReplayBadHeaderTest, "SatJam.Match3.Replay.BadHeader",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FMatch3ReplayBadHeaderTest::RunTest(const FString& Parameters)
+{
+    FMatch3Board Board;
+    Board.Init(10, 6, 1);
+    Board.Regenerate();
+
+    FMatch3Replay Recorded;
+    Recorded.Begin(Board, 1);
+    Recorded.Finish(Board);
+
+    // header: magic, version, rows, cols, colors
+    auto LoadWith = [&Recorded](uint16 Rows, uint16 Cols, uint8 NumColors)
+    {
+        TArray<uint8> Data;
+        FMemoryWriter Writer(Data);
+        Recorded.Serialize(Writer);
+        FMemory::Memcpy(&Data[6], &Rows, sizeof(Rows));
+        FMemory::Memcpy(&Data[8], &Cols, sizeof(Cols));
+        Data[10] = NumColors;
+
+        FMatch3Replay Loaded;
+        FMemoryReader Reader(Data);
+        return Loaded.Serialize(Reader);
+    };
+
+    TestTrue(TEXT("unchanged header loads"), LoadWith(10, 6, 4));
+    TestFalse(TEXT("zero rows"), LoadWith(0, 6, 4));
+    TestFalse(TEXT("huge board"), LoadWith(65535, 65535, 4));
+    TestFalse(TEXT("too few colors"), LoadWith(10, 6, 2));
+    TestFalse(TEXT("too many colors"), LoadWith(10, 6, 9));
+    return true;
+}
+
+#endif
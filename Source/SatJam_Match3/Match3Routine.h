@@ -0,0 +1,142 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/World.h"
+#include "TimerManager.h"
+#include <coroutine>
+
+// game thread coroutine for presentation sequences (the grid's cascade)
+// starts running as soon as it is called and suspends at co_await Match3Delay;
+// the owner keeps the returned FMatch3Routine, resetting it cancels the routine
+class FMatch3Routine
+{
+public:
+    struct promise_type
+    {
+        // pending delay, cleared on cancel
+        TWeakObjectPtr<UWorld> World;
+        FTimerHandle Timer;
+
+        // executing right now (not waiting for a delay or finished)
+        bool bRunning = true;
+
+        // the owner let go while it was running, it frees itself when it returns
+        bool bOrphaned = false;
+
+        struct FFinalAwaiter
+        {
+            bool await_ready() const noexcept { return false; }
+            bool await_suspend(std::coroutine_handle<promise_type> Handle) noexcept
+            {
+                // false resumes straight into destruction
+                Handle.promise().bRunning = false;
+                return !Handle.promise().bOrphaned;
+            }
+            void await_resume() const noexcept {}
+        };
+
+        FMatch3Routine get_return_object() { return FMatch3Routine(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        std::suspend_never initial_suspend() const noexcept { return {}; }
+        FFinalAwaiter final_suspend() const noexcept { return {}; }
+        void return_void() const {}
+        void unhandled_exception() const { check(false); }
+    };
+
+    FMatch3Routine() = default;
+    FMatch3Routine(const FMatch3Routine&) = delete;
+    FMatch3Routine& operator=(const FMatch3Routine&) = delete;
+
+    FMatch3Routine(FMatch3Routine&& Other)
+        : Handle(Other.Handle)
+    {
+        Other.Handle = nullptr;
+    }
+
+    FMatch3Routine& operator=(FMatch3Routine&& Other)
+    {
+        if (this != &Other)
+        {
+            Reset();
+            Handle = Other.Handle;
+            Other.Handle = nullptr;
+        }
+        return *this;
+    }
+
+    ~FMatch3Routine()
+    {
+        Reset();
+    }
+
+    // still has work to do
+    bool IsActive() const { return Handle && !Handle.done(); }
+
+    // cancel: a waiting routine is dropped with its delay, a running one (the owner was
+    // reset from inside it) finishes the current step and frees itself
+    void Reset()
+    {
+        if (!Handle) return;
+
+        promise_type& Promise = Handle.promise();
+        if (Promise.bRunning)
+        {
+            Promise.bOrphaned = true;
+        }
+        else
+        {
+            if (UWorld* World = Promise.World.Get())
+            {
+                World->GetTimerManager().ClearTimer(Promise.Timer);
+            }
+            Handle.destroy();
+        }
+        Handle = nullptr;
+    }
+
+private:
+    explicit FMatch3Routine(std::coroutine_handle<promise_type> InHandle)
+        : Handle(InHandle)
+    {
+    }
+
+    std::coroutine_handle<promise_type> Handle;
+};
+
+// co_await Match3Delay(Owner, Seconds): resume after Seconds of Owner's world time
+// (pauses and dilation apply); 0 or less continues without suspending
+struct Match3Delay
+{
+    const UObject* Owner;
+    float Seconds;
+
+    Match3Delay(const UObject* InOwner, float InSeconds)
+        : Owner(InOwner)
+        , Seconds(InSeconds)
+    {
+    }
+
+    bool await_ready() const noexcept
+    {
+        return Seconds <= 0.f || !Owner || !Owner->GetWorld();
+    }
+
+    void await_suspend(std::coroutine_handle<FMatch3Routine::promise_type> Handle) const
+    {
+        FMatch3Routine::promise_type& Promise = Handle.promise();
+        Promise.bRunning = false;
+        Promise.World = Owner->GetWorld();
+        Promise.World->GetTimerManager().SetTimer(
+            Promise.Timer,
+            FTimerDelegate::CreateWeakLambda(Owner, [Handle]()
+            {
+                Handle.promise().bRunning = true;
+                Handle.resume();
+            }),
+            Seconds,
+            false);
+    }
+
+    void await_resume() const noexcept {}
+};
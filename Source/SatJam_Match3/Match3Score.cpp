@@ -0,0 +1,44 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Match3Score.h"
+
+int32 FMatch3ScoreRules::GetGroupPoints(const FMatch3Group& Group) const
+{
+    const int32 Base = PointsPerClear * FMath::Max(1, Group.NumCells / 3);
+    return Base + Base * ShapeBonusPercent[static_cast<int32>(Group.Shape)] / 100;
+}
+
+
+int32 FMatch3ScoreRules::GetCascadePercent(int32 CascadeDepth) const
+{
+    return 100 + FMath::Max(0, CascadeDepth - 1) * CascadeBonusPercent;
+}
+
+
+void FMatch3ScoreAccumulator::BeginTurn()
+{
+    Turn = FMatch3TurnScore();
+}
+
+
+void FMatch3ScoreAccumulator::AddClear(const FMatch3GroupBuffer& Groups, int32 CascadeDepth)
+{
+    int32 StepPoints = 0;
+    for (const FMatch3Group& Group : Groups.Groups)
+    {
+        StepPoints += Rules.GetGroupPoints(Group);
+    }
+
+    Turn.Points += StepPoints * Rules.GetCascadePercent(CascadeDepth) / 100;
+    Turn.Groups += Groups.Groups.Num();
+    Turn.CellsCleared += Groups.MatchedCells.Num();
+    Turn.CascadeDepth = FMath::Max(Turn.CascadeDepth, CascadeDepth);
+}
+
+
+int32 FMatch3ScoreAccumulator::CommitTurn(int32& Score)
+{
+    Score += Turn.Points;
+    return Turn.Points;
+}
@@ -0,0 +1,47 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Match3Groups.h"
+
+// points for clears, integer only
+struct FMatch3ScoreRules
+{
+    // a line of three; bigger groups scale by cell count
+    int32 PointsPerClear = 100;
+
+    // extra percent per cascade step after the first (50 => x1, x1.5, x2, ...)
+    int32 CascadeBonusPercent = 50;
+
+    // extra percent per group shape, indexed by EMatch3Shape
+    int32 ShapeBonusPercent[7] = { 0, 50, 100, 50, 50, 100, 0 };
+
+    int32 GetGroupPoints(const FMatch3Group& Group) const;
+    int32 GetCascadePercent(int32 CascadeDepth) const;
+};
+
+// what one resolved turn added up to
+struct FMatch3TurnScore
+{
+    int32 Points = 0;
+    int32 Groups = 0;
+    int32 CellsCleared = 0;
+    int32 CascadeDepth = 0;
+};
+
+// collects clear events from every resolution path (timer steps, synchronous
+// cascades, headless playback) and applies them to the score once per turn
+struct SATJAM_MATCH3_API FMatch3ScoreAccumulator
+{
+    FMatch3ScoreRules Rules;
+    FMatch3TurnScore Turn;
+
+    void BeginTurn();
+
+    // one cascade step clearing these groups, depth starts at 1
+    void AddClear(const FMatch3GroupBuffer& Groups, int32 CascadeDepth);
+
+    // add the turn to Score, returns the points it was worth
+    int32 CommitTurn(int32& Score);
+};
@@ -0,0 +1,24 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Match3Scratch.h"
+#include <atomic>
+
+static std::atomic<int64> GMatch3ScratchAllocations(0);
+
+int64 Match3Scratch::GetAllocationCount()
+{
+    return GMatch3ScratchAllocations.load(std::memory_order_relaxed);
+}
+
+
+void Match3Scratch::ResetAllocationCount()
+{
+    GMatch3ScratchAllocations.store(0, std::memory_order_relaxed);
+}
+
+
+void Match3Scratch::NoteAllocation()
+{
+    GMatch3ScratchAllocations.fetch_add(1, std::memory_order_relaxed);
+}
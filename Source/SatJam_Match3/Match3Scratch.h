@@ -0,0 +1,49 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+namespace Match3Scratch
+{
+    // heap allocations made by scratch buffers since the last reset
+    // steady-state swap resolution is expected to keep this at zero
+    SATJAM_MATCH3_API int64 GetAllocationCount();
+    SATJAM_MATCH3_API void ResetAllocationCount();
+    SATJAM_MATCH3_API void NoteAllocation();
+}
+
+// default heap allocator that counts every (re)allocation in Match3Scratch
+// used by the rule scratch buffers, which are reserved from Rows * Cols up front
+class FMatch3ScratchAllocator : public FDefaultAllocator
+{
+public:
+    template <typename ElementType>
+    class ForElementType : public FDefaultAllocator::ForElementType<ElementType>
+    {
+        using Super = FDefaultAllocator::ForElementType<ElementType>;
+
+    public:
+        template <typename SizeType>
+        void ResizeAllocation(SizeType CurrentNum, SizeType NewMax, SIZE_T NumBytesPerElement)
+        {
+            if (NewMax > 0) Match3Scratch::NoteAllocation();
+            Super::ResizeAllocation(CurrentNum, NewMax, NumBytesPerElement);
+        }
+
+        template <typename SizeType>
+        void ResizeAllocation(SizeType CurrentNum, SizeType NewMax, SIZE_T NumBytesPerElement, uint32 AlignmentOfElement)
+        {
+            if (NewMax > 0) Match3Scratch::NoteAllocation();
+            Super::ResizeAllocation(CurrentNum, NewMax, NumBytesPerElement, AlignmentOfElement);
+        }
+    };
+};
+
+template <>
+struct TAllocatorTraits<FMatch3ScratchAllocator> : TAllocatorTraits<FDefaultAllocator>
+{
+};
+
+// cell index list written by the rule scans (matches, groups)
+using FMatch3CellList = TArray<int32, FMatch3ScratchAllocator>;
@@ -0,0 +1,63 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Match3Scratch.h"
+#include "Match3Board.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMatch3SwapAllocationTest, "SatJam.Match3.Scratch.NoAllocationsPerSwap",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FMatch3SwapAllocationTest::RunTest(const FString& Parameters)
+{
+    constexpr int32 NumSwaps = 500;
+
+    // one kernel size and one generic size, shuffles and regenerates included
+    const FIntPoint Sizes[] = { { 10, 6 }, { 9, 9 } };
+    for (const FIntPoint& Size : Sizes)
+    {
+        FMatch3Board Board;
+        Board.Init(Size.X, Size.Y, 7);
+        Board.bShuffleDeadBoards = true;
+        Board.Regenerate();
+
+        // what AMatch3Grid::StartSwap does with a queued swap: predict the turn on a
+        // second board, then resolve it; the first copy sizes the prediction
+        FMatch3Board PredictedBoard;
+        PredictedBoard.CopyFrom(Board);
+
+        FMatch3MoveList Moves;
+        Moves.Reserve(Board.Num());
+        FRandomStream Picks(Size.X * Size.Y);
+
+        const uint8* BoardCells = Board.Cells.GetData();
+        const uint8* PredictedCells = PredictedBoard.Cells.GetData();
+        Match3Scratch::ResetAllocationCount();
+
+        for (int32 i = 0; i < NumSwaps; ++i)
+        {
+            Board.FindAllMoves(Moves);
+            if (Moves.Moves.Num() == 0)
+            {
+                Board.Regenerate();
+                continue;
+            }
+            const FMatch3Move& Move = Moves.Moves[Picks.RandHelper(Moves.Moves.Num())];
+
+            TestTrue(TEXT("listed move is legal"), Board.TrySwap(Move.CellA, Move.CellB));
+            int32 Depth = 0;
+            PredictedBoard.CopyFrom(Board);
+            PredictedBoard.ResolveCascade(Depth);
+            Board.ResolveTurn();
+        }
+
+        TestEqual(TEXT("scratch allocations while resolving swaps"), Match3Scratch::GetAllocationCount(), static_cast<int64>(0));
+        TestTrue(TEXT("board cells were not reallocated"), Board.Cells.GetData() == BoardCells);
+        TestTrue(TEXT("predicted cells were not reallocated"), PredictedBoard.Cells.GetData() == PredictedCells);
+    }
+    return true;
+}
+
+#endif
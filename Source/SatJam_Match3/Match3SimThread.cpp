@@ -0,0 +1,195 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Match3SimThread.h"
+#include "Match3Snapshot.h"
+#include "HAL/Event.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/RunnableThread.h"
+
+FMatch3SimThread::FMatch3SimThread(const FMatch3Board& Start)
+    : Board(Start)
+{
+    Groups.Reserve(Board.Num());
+    ShuffleSource.Reserve(Board.Num());
+    WakeEvent = FPlatformProcess::GetSynchEventFromPool(false);
+    Thread = FRunnableThread::Create(this, TEXT("Match3Sim"), 0, TPri_Normal);
+}
+
+
+FMatch3SimThread::~FMatch3SimThread()
+{
+    if (Thread)
+    {
+        // Kill calls Stop and waits for Run to return
+        Thread->Kill(true);
+        delete Thread;
+        Thread = nullptr;
+    }
+
+    FPlatformProcess::ReturnSynchEventToPool(WakeEvent);
+    WakeEvent = nullptr;
+}
+
+
+bool FMatch3SimThread::PushSwap(int32 CellA, int32 CellB)
+{
+    if (!Commands.Push({ CellA, CellB })) return false;
+    WakeEvent->Trigger();
+    return true;
+}
+
+
+bool FMatch3SimThread::PopEvent(FMatch3SimEvent& Out)
+{
+    FMatch3SimEvent* Event = Events.Peek();
+    if (!Event) return false;
+
+    Swap(Out, *Event);
+    Events.Pop();
+    return true;
+}
+
+
+uint32 FMatch3SimThread::Run()
+{
+    Board.Regenerate();
+    ++Sequence;
+    PublishBoard();
+
+    while (!bStopping)
+    {
+        const FMatch3SimCommand* Command = Commands.Peek();
+        if (!Command)
+        {
+            WakeEvent->Wait();
+            continue;
+        }
+
+        const int32 CellA = Command->CellA;
+        const int32 CellB = Command->CellB;
+        Commands.Pop();
+
+        if (!Board.AreAdjacent(CellA, CellB)) continue;
+
+        const bool bAccepted = Board.TrySwap(CellA, CellB);
+        if (FMatch3SimEvent* Event = BeginEvent(EMatch3SimEventType::Swap))
+        {
+            const int32 First = FMath::Min(CellA, CellB);
+            Event->Swap = (First << 1) | (FMath::Abs(CellA - CellB) != 1 ? 1 : 0);
+            Event->bAccepted = bAccepted;
+            Events.FinishPush();
+        }
+
+        if (bAccepted)
+        {
+            ResolveTurn();
+        }
+    }
+    return 0;
+}
+
+
+void FMatch3SimThread::Stop()
+{
+    bStopping = true;
+    WakeEvent->Trigger();
+}
+
+
+FMatch3SimEvent* FMatch3SimThread::BeginEvent(EMatch3SimEventType Type)
+{
+    // the game thread drains every frame, a full ring only means a long hitch
+    FMatch3SimEvent* Event = Events.BeginPush();
+    while (!Event && !bStopping)
+    {
+        FPlatformProcess::SleepNoStats(0.001f);
+        Event = Events.BeginPush();
+    }
+    if (!Event) return nullptr;
+
+    // slots are reused, keep their buffers
+    Event->Type = Type;
+    Event->Sequence = Sequence;
+    Event->ClearedCells.Reset();
+    Event->ChangedCells.Reset();
+    Event->ChangedColors.Reset();
+    Event->Snapshot.Reset();
+    return Event;
+}
+
+
+void FMatch3SimThread::ResolveTurn()
+{
+    ++Sequence;
+    int32 Depth = 0;
+    Board.BeginCascade(Groups);
+
+    bool bMore = Groups.MatchedCells.Num() > 0;
+    while (bMore)
+    {
+        FMatch3SimEvent* Event = BeginEvent(EMatch3SimEventType::Step);
+        if (!Event) return;
+
+        Event->ClearedCells.Append(Groups.MatchedCells.GetData(), Groups.MatchedCells.Num());
+        bMore = Board.StepCascade(Groups, Depth);
+
+        const FMatch3CellList& Changed = Board.GetChangedCells();
+        Event->ChangedCells.Append(Changed.GetData(), Changed.Num());
+        for (int32 Cell : Changed)
+        {
+            Event->ChangedColors.Add(Board.Cells[Cell]);
+        }
+        Event->Depth = Depth;
+        Event->Points = Board.Scoring.Turn.Points;
+        Events.FinishPush();
+    }
+
+    const bool bRegenerate = Board.EndCascade(Groups, Depth);
+    if (FMatch3SimEvent* Event = BeginEvent(EMatch3SimEventType::TurnEnd))
+    {
+        Event->Depth = Depth;
+        Event->Points = Board.Scoring.Turn.Points;
+        Event->CellsCleared = Board.Scoring.Turn.CellsCleared;
+        Event->Score = Board.Score;
+        if (!bRegenerate)
+        {
+            WriteBoard(Event->Snapshot);
+        }
+        Events.FinishPush();
+    }
+    if (!bRegenerate) return;
+
+    // same order as ResolveTurn: shuffle if enabled, otherwise a new board
+    if (Board.bShuffleDeadBoards && Board.Shuffle(&ShuffleSource))
+    {
+        if (FMatch3SimEvent* Event = BeginEvent(EMatch3SimEventType::Shuffle))
+        {
+            Event->ChangedCells.Append(ShuffleSource.GetData(), ShuffleSource.Num());
+            Event->ChangedColors.Append(Board.Cells);
+            WriteBoard(Event->Snapshot);
+            Events.FinishPush();
+        }
+        return;
+    }
+
+    Board.Regenerate();
+    PublishBoard();
+}
+
+
+void FMatch3SimThread::PublishBoard()
+{
+    FMatch3SimEvent* Event = BeginEvent(EMatch3SimEventType::Board);
+    if (!Event) return;
+
+    WriteBoard(Event->Snapshot);
+    Events.FinishPush();
+}
+
+
+void FMatch3SimThread::WriteBoard(TArray<uint8>& Snapshot) const
+{
+    Snapshot.SetNumZeroed(FMatch3Snapshot::GetRecordSize(Board.Rows, Board.Cols, Board.NumColors));
+    FMatch3Snapshot::Write(Board, false, Snapshot);
+}
@@ -0,0 +1,102 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include "Match3Board.h"
+#include "Match3SpscRing.h"
+
+class FRunnableThread;
+class FEvent;
+
+struct FMatch3SimCommand
+{
+    int32 CellA = 0;
+    int32 CellB = 0;
+};
+
+enum class EMatch3SimEventType : uint8
+{
+    Board,      // Snapshot is the whole board: the start, or a dead board regenerated
+    Swap,       // Swap was checked; when accepted, its turn's events follow
+    Step,       // one cascade step of the running turn
+    TurnEnd,    // the running turn's score is committed
+    Shuffle     // a dead board was shuffled
+};
+
+// what the thread did, in order, for the grid to animate without running the rules
+// Sequence counts accepted turns like the board host's, the starting board is 1
+struct FMatch3SimEvent
+{
+    EMatch3SimEventType Type = EMatch3SimEventType::Board;
+    int32 Sequence = 0;
+
+    // Swap: packed like FMatch3Replay swaps
+    int32 Swap = INDEX_NONE;
+    bool bAccepted = false;
+
+    // Step: the cleared cells, then every cell the drop and refill changed with its
+    // new color; tiles fall by the board's own compaction of the cleared cells
+    // Shuffle: ChangedCells[i] is the old cell of the color now at i, ChangedColors all cells
+    TArray<int32> ClearedCells;
+    TArray<int32> ChangedCells;
+    TArray<uint8> ChangedColors;
+
+    // Step: depth and the turn's points so far; TurnEnd: the turn's totals and the score after it
+    int32 Depth = 0;
+    int32 Points = 0;
+    int32 CellsCleared = 0;
+    int32 Score = 0;
+
+    // Board, and whichever of TurnEnd or Shuffle settles a turn: FMatch3Snapshot of the
+    // settled board, which a server forwards to its clients
+    TArray<uint8> Snapshot;
+};
+
+// one board's rules on a thread of their own
+// the game thread pushes swaps and drains results through lock-free rings, so a
+// swap costs it a ring push however long the cascade takes to resolve
+class SATJAM_MATCH3_API FMatch3SimThread : public FRunnable
+{
+public:
+    static constexpr uint32 QueueSize = 64;
+
+    // Start is set up with Init and its rules; the thread fills it with Regenerate
+    // and reports it as the first event
+    explicit FMatch3SimThread(const FMatch3Board& Start);
+    virtual ~FMatch3SimThread();
+
+    // game thread: false if the command ring is full, the swap is dropped
+    bool PushSwap(int32 CellA, int32 CellB);
+
+    // game thread: next event, Out's buffers go back to the thread for reuse
+    bool PopEvent(FMatch3SimEvent& Out);
+
+    // FRunnable
+    virtual uint32 Run() override;
+    virtual void Stop() override;
+
+private:
+    // wait for room in the event ring and start an event of Type, null if stopping
+    FMatch3SimEvent* BeginEvent(EMatch3SimEventType Type);
+
+    // the steps of FMatch3Board::ResolveTurn, each published as it runs
+    void ResolveTurn();
+
+    void PublishBoard();
+    void WriteBoard(TArray<uint8>& Snapshot) const;
+
+    // thread side
+    FMatch3Board Board;
+    FMatch3GroupBuffer Groups;
+    FMatch3CellList ShuffleSource;
+    int32 Sequence = 0;
+
+    TMatch3SpscRing<FMatch3SimCommand, QueueSize> Commands;
+    TMatch3SpscRing<FMatch3SimEvent, QueueSize> Events;
+
+    FEvent* WakeEvent = nullptr;
+    FRunnableThread* Thread = nullptr;
+    TAtomic<bool> bStopping { false };
+};
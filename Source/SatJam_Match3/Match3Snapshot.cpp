@@ -0,0 +1,246 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Match3Snapshot.h"
+#include "Async/MappedFileHandle.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFileManager.h"
+
+static_assert(sizeof(FMatch3SnapshotHeader) == 24, "snapshot header layout changed, bump CurrentVersion");
+
+namespace
+{
+    // every packed color below NumColors; holes are stored as 0, so nothing else is valid
+    bool ArePackedColorsValid(const uint8* Packed, int32 Bits, int32 NumCells, int32 NumColors)
+    {
+        const uint32 Mask = (1u << Bits) - 1;
+        uint64 Acc = 0;
+        int32 AccBits = 0;
+        for (int32 i = 0; i < NumCells; ++i)
+        {
+            if (AccBits < Bits)
+            {
+                Acc |= static_cast<uint64>(*Packed++) << AccBits;
+                AccBits += 8;
+            }
+            if ((Acc & Mask) >= static_cast<uint32>(NumColors)) return false;
+            Acc >>= Bits;
+            AccBits -= Bits;
+        }
+        return true;
+    }
+}
+
+int32 FMatch3Snapshot::GetBitsPerCell(int32 NumColors)
+{
+    return FMath::Max<int32>(1, FMath::CeilLogTwo(static_cast<uint32>(NumColors)));
+}
+
+
+int32 FMatch3Snapshot::GetNumColors(const FMatch3SnapshotHeader& Header)
+{
+    if (Header.Magic != Magic || Header.Version > CurrentVersion) return 0;
+    if (!FMatch3Board::IsSupportedSize(Header.Rows, Header.Cols)) return 0;
+
+    const int32 NumColors = Header.Version >= 2 ? Header.NumColors : 4;
+    if (NumColors < FMatch3Board::MinColors || NumColors > FMatch3Board::MaxColors) return 0;
+    return NumColors;
+}
+
+
+int32 FMatch3Snapshot::GetRecordSize(int32 Rows, int32 Cols, int32 NumColors)
+{
+    const int32 PackedBytes = FMath::DivideAndRoundUp(Rows * Cols * GetBitsPerCell(NumColors), 8);
+
+    // keep records 4-byte aligned so headers can be read in place
+    return sizeof(FMatch3SnapshotHeader) + Align(PackedBytes, 4);
+}
+
+
+bool FMatch3Snapshot::PackCells(TConstArrayView<uint8> Cells, int32 Bits, uint8* Out)
+{
+    const uint32 Limit = 1u << Bits;
+    uint64 Acc = 0;
+    int32 AccBits = 0;
+    for (uint8 Color : Cells)
+    {
+        if (Color >= Limit && Color != FMatch3Board::NoCell) return false;
+
+        Acc |= static_cast<uint64>(Color == FMatch3Board::NoCell ? 0 : Color) << AccBits;
+        AccBits += Bits;
+        while (AccBits >= 8)
+        {
+            *Out++ = static_cast<uint8>(Acc);
+            Acc >>= 8;
+            AccBits -= 8;
+        }
+    }
+    if (AccBits > 0)
+    {
+        *Out = static_cast<uint8>(Acc);
+    }
+    return true;
+}
+
+
+void FMatch3Snapshot::UnpackCells(const uint8* Packed, int32 Bits, TArrayView<uint8> Cells)
+{
+    const uint32 Mask = (1u << Bits) - 1;
+    uint64 Acc = 0;
+    int32 AccBits = 0;
+    for (uint8& Color : Cells)
+    {
+        if (AccBits < Bits)
+        {
+            Acc |= static_cast<uint64>(*Packed++) << AccBits;
+            AccBits += 8;
+        }
+        Color = static_cast<uint8>(Acc & Mask);
+        Acc >>= Bits;
+        AccBits -= Bits;
+    }
+}
+
+
+bool FMatch3Snapshot::Write(const FMatch3Board& Board, bool bInputLocked, TArrayView<uint8> Out)
+{
+    const int32 RecordSize = GetRecordSize(Board.Rows, Board.Cols, Board.NumColors);
+    if (Out.Num() < RecordSize) return false;
+
+    FMatch3SnapshotHeader Header;
+    Header.Magic = Magic;
+    Header.Version = CurrentVersion;
+    Header.NumColors = static_cast<uint8>(Board.NumColors);
+    Header.BitsPerCell = static_cast<uint8>(GetBitsPerCell(Board.NumColors));
+    Header.Flags = bInputLocked ? FlagInputLocked : 0;
+    Header.Rows = static_cast<uint16>(Board.Rows);
+    Header.Cols = static_cast<uint16>(Board.Cols);
+    Header.Score = Board.Score;
+    Header.RandSeed = Board.Stream.GetCurrentSeed();
+    Header.PackedBytes = RecordSize - sizeof(FMatch3SnapshotHeader);
+    FMemory::Memcpy(Out.GetData(), &Header, sizeof(Header));
+
+    // the padding after the colors stays zero
+    uint8* Packed = Out.GetData() + sizeof(Header);
+    FMemory::Memzero(Packed, Header.PackedBytes);
+
+    for (uint8 Color : Board.Cells)
+    {
+        if (Color >= Board.NumColors && Color != FMatch3Board::NoCell) return false;
+    }
+    return PackCells(Board.Cells, Header.BitsPerCell, Packed);
+}
+
+
+bool FMatch3Snapshot::Read(TConstArrayView<uint8> Data, FMatch3Board& Board, bool& bOutInputLocked)
+{
+    if (Data.Num() < static_cast<int32>(sizeof(FMatch3SnapshotHeader))) return false;
+
+    FMatch3SnapshotHeader Header;
+    FMemory::Memcpy(&Header, Data.GetData(), sizeof(Header));
+    const int32 NumColors = GetNumColors(Header);
+    if (NumColors == 0) return false;
+
+    // only the width Write uses, so a record cannot carry border, empty or out of range colors
+    const int32 Bits = Header.BitsPerCell;
+    const int32 NumCells = Header.Rows * Header.Cols;
+    if (Bits != GetBitsPerCell(NumColors) || static_cast<int64>(NumCells) * Bits > static_cast<int64>(Header.PackedBytes) * 8) return false;
+    if (Data.Num() < static_cast<int32>(sizeof(Header) + Header.PackedBytes)) return false;
+    if (!ArePackedColorsValid(Data.GetData() + sizeof(Header), Bits, NumCells, NumColors)) return false;
+
+    if (Board.Rows != Header.Rows || Board.Cols != Header.Cols)
+    {
+        Board.Rows = Header.Rows;
+        Board.Cols = Header.Cols;
+        Board.SelectKernel();
+
+        // the shape belonged to the old size
+        Board.Shape.Reset();
+    }
+    if (Board.NumColors != NumColors)
+    {
+        Board.SetNumColors(NumColors);
+    }
+    Board.Score = Header.Score;
+    Board.Stream.Initialize(Header.RandSeed);
+    Board.Cells.SetNumUninitialized(NumCells, EAllowShrinking::No);
+    bOutInputLocked = (Header.Flags & FlagInputLocked) != 0;
+
+    UnpackCells(Data.GetData() + sizeof(Header), Bits, Board.Cells);
+    Board.CellsChanged();
+
+    return true;
+}
+
+
+bool FMatch3Snapshot::SaveToFile(const FMatch3Board& Board, bool bInputLocked, const FString& Filename, bool bAppend)
+{
+    TArray<uint8> Record;
+    Record.SetNumZeroed(GetRecordSize(Board.Rows, Board.Cols, Board.NumColors));
+    if (!Write(Board, bInputLocked, Record)) return false;
+
+    TUniquePtr<FArchive> Writer(IFileManager::Get().CreateFileWriter(*Filename, bAppend ? FILEWRITE_Append : 0));
+    if (!Writer) return false;
+    Writer->Serialize(Record.GetData(), Record.Num());
+    return Writer->Close();
+}
+
+
+FMatch3MappedSnapshots::FMatch3MappedSnapshots() = default;
+
+FMatch3MappedSnapshots::~FMatch3MappedSnapshots()
+{
+    Close();
+}
+
+
+bool FMatch3MappedSnapshots::Open(const FString& Filename)
+{
+    Close();
+
+    FOpenMappedResult Result = FPlatformFileManager::Get().GetPlatformFile().OpenMappedEx(*Filename);
+    if (Result.HasError()) return false;
+    Handle = Result.StealValue();
+
+    Region.Reset(Handle->MapRegion());
+    if (!Region || Region->GetMappedSize() < static_cast<int64>(sizeof(FMatch3SnapshotHeader)))
+    {
+        Close();
+        return false;
+    }
+
+    // every record in a file has the size of the first one, which has to be the
+    // size Write makes for its header
+    FMatch3SnapshotHeader Header;
+    FMemory::Memcpy(&Header, Region->GetMappedPtr(), sizeof(Header));
+    const int32 NumColors = FMatch3Snapshot::GetNumColors(Header);
+    const int32 ExpectedSize = NumColors > 0 ? FMatch3Snapshot::GetRecordSize(Header.Rows, Header.Cols, NumColors) : 0;
+    if (ExpectedSize == 0 || static_cast<int64>(sizeof(FMatch3SnapshotHeader)) + Header.PackedBytes != ExpectedSize
+        || Region->GetMappedSize() < ExpectedSize)
+    {
+        Close();
+        return false;
+    }
+
+    RecordSize = ExpectedSize;
+    NumRecords = static_cast<int32>(Region->GetMappedSize() / RecordSize);
+    return true;
+}
+
+
+void FMatch3MappedSnapshots::Close()
+{
+    Region.Reset();
+    Handle.Reset();
+    RecordSize = 0;
+    NumRecords = 0;
+}
+
+
+bool FMatch3MappedSnapshots::Restore(int32 Index, FMatch3Board& Board, bool& bOutInputLocked) const
+{
+    if (!Region || Index < 0 || Index >= NumRecords) return false;
+
+    const uint8* Record = Region->GetMappedPtr() + static_cast<int64>(Index) * RecordSize;
+    return FMatch3Snapshot::Read(MakeArrayView(Record, RecordSize), Board, bOutInputLocked);
+}
@@ -0,0 +1,82 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Match3Board.h"
+
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+// fixed-layout board snapshot: header followed by the colors packed at
+// BitsPerCell (2 bits for up to four colors, 3 for up to eight)
+// the layout is read in place, so a mapped file restores without parsing
+struct FMatch3SnapshotHeader
+{
+    uint32 Magic;
+    uint8 Version;
+    uint8 NumColors;    // 0 in version 1 records, which always had four
+    uint8 BitsPerCell;
+    uint8 Flags;
+    uint16 Rows;
+    uint16 Cols;
+    int32 Score;
+    int32 RandSeed;     // current FRandomStream state
+    uint32 PackedBytes; // size of the packed colors after the header
+};
+
+struct SATJAM_MATCH3_API FMatch3Snapshot
+{
+    static constexpr uint32 Magic = 0x4E53334D; // "M3SN"
+    static constexpr uint8 CurrentVersion = 2;
+
+    // header flags
+    static constexpr uint8 FlagInputLocked = 1 << 0;
+
+    static int32 GetBitsPerCell(int32 NumColors);
+
+    // color count of a header, 0 if the version or board is not supported
+    static int32 GetNumColors(const FMatch3SnapshotHeader& Header);
+
+    // size of one snapshot record for a board
+    static int32 GetRecordSize(int32 Rows, int32 Cols, int32 NumColors);
+
+    // colors low bits first at Bits each into DivideAndRoundUp(Num * Bits, 8) bytes,
+    // holes as color 0; false on a color that does not fit
+    static bool PackCells(TConstArrayView<uint8> Cells, int32 Bits, uint8* Out);
+    static void UnpackCells(const uint8* Packed, int32 Bits, TArrayView<uint8> Cells);
+
+    // write into Out (at least GetRecordSize bytes), allocates nothing
+    // the board has to be settled (no empty cells); holes are stored as color 0
+    // and put back by the shape of the board that reads it
+    static bool Write(const FMatch3Board& Board, bool bInputLocked, TArrayView<uint8> Out);
+
+    // restore into Board, color count included; allocates nothing if Board already has the same size
+    // false (Board untouched) on a bad header or a color outside the record's color count
+    static bool Read(TConstArrayView<uint8> Data, FMatch3Board& Board, bool& bOutInputLocked);
+
+    // appends one record to a file, so many boards can share one mapped file
+    static bool SaveToFile(const FMatch3Board& Board, bool bInputLocked, const FString& Filename, bool bAppend = false);
+};
+
+// memory-mapped snapshot file holding one or more records of the same size
+class SATJAM_MATCH3_API FMatch3MappedSnapshots
+{
+public:
+    FMatch3MappedSnapshots();
+    ~FMatch3MappedSnapshots();
+
+    bool Open(const FString& Filename);
+    void Close();
+
+    int32 Num() const { return NumRecords; }
+
+    // restore record Index straight from the mapped region
+    bool Restore(int32 Index, FMatch3Board& Board, bool& bOutInputLocked) const;
+
+private:
+    TUniquePtr<IMappedFileHandle> Handle;
+    TUniquePtr<IMappedFileRegion> Region;
+    int32 RecordSize = 0;
+    int32 NumRecords = 0;
+};
@@ -0,0 +1,148 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Match3Snapshot.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    // a settled board a few turns into a game
+    void MakePlayedBoard(FMatch3Board& Board, int32 Rows, int32 Cols, int32 NumColors, int32 Seed)
+    {
+        Board.Init(Rows, Cols, Seed);
+        Board.SetNumColors(NumColors);
+        Board.Regenerate();
+        for (int32 Turn = 0; Turn < 20; ++Turn)
+        {
+            const int32 CellA = Board.Stream.RandHelper(Board.Num());
+            const int32 CellB = Board.Stream.RandBool() ? CellA + 1 : CellA + Cols;
+            if (Board.AreAdjacent(CellA, CellB) && Board.TrySwap(CellA, CellB))
+            {
+                Board.ResolveTurn();
+            }
+        }
+    }
+
+    TArray<uint8> WriteRecord(const FMatch3Board& Board, bool bInputLocked)
+    {
+        TArray<uint8> Record;
+        Record.SetNumZeroed(FMatch3Snapshot::GetRecordSize(Board.Rows, Board.Cols, Board.NumColors));
+        FMatch3Snapshot::Write(Board, bInputLocked, Record);
+        return Record;
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMatch3SnapshotRoundTripTest, "SatJam.Match3.Snapshot.RoundTrip",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FMatch3SnapshotRoundTripTest::RunTest(const FString& Parameters)
+{
+    const FIntPoint Sizes[] = { { 10, 6 }, { 9, 9 }, { 3, 3 }, { 32, 32 } };
+    for (const FIntPoint& Size : Sizes)
+    {
+        for (int32 NumColors = FMatch3Board::MinColors; NumColors <= FMatch3Board::MaxColors; ++NumColors)
+        {
+            FMatch3Board Board;
+            MakePlayedBoard(Board, Size.X, Size.Y, NumColors, Size.X * 10 + NumColors);
+            const bool bLocked = (NumColors & 1) != 0;
+            const TArray<uint8> Record = WriteRecord(Board, bLocked);
+
+            // into a board of another size and color count
+            FMatch3Board Loaded;
+            Loaded.Init(6, 6, 1);
+            bool bLoadedLocked = !bLocked;
+            if (!TestTrue(TEXT("record reads"), FMatch3Snapshot::Read(Record, Loaded, bLoadedLocked))) continue;
+
+            TestTrue(TEXT("cells"), Loaded.Cells == Board.Cells);
+            TestEqual(TEXT("rows"), Loaded.Rows, Board.Rows);
+            TestEqual(TEXT("colors"), Loaded.NumColors, Board.NumColors);
+            TestEqual(TEXT("score"), Loaded.Score, Board.Score);
+            TestEqual(TEXT("stream"), Loaded.Stream.GetCurrentSeed(), Board.Stream.GetCurrentSeed());
+            TestEqual(TEXT("lock flag"), bLoadedLocked, bLocked);
+            TestEqual(TEXT("hash"), Loaded.Hash, Board.Hash);
+
+            // the same refills follow, so play continues identically
+            Board.RegenerateFromSeed(7);
+            Loaded.RegenerateFromSeed(7);
+            Board.Regenerate();
+            Loaded.Regenerate();
+            TestTrue(TEXT("same board after regenerating"), Loaded.Cells == Board.Cells);
+        }
+    }
+
+    // holes are stored as color 0 and put back by the reading board's shape
+    FMatch3Board Shaped;
+    Shaped.Init(9, 9, 3);
+    const FIntPoint Holes[] = { { 0, 0 }, { 4, 4 } };
+    const TSharedRef<const FMatch3BoardShape> Shape = FMatch3BoardShape::Make(9, 9, Holes, TConstArrayView<FIntPoint>());
+    Shaped.SetShape(Shape);
+    Shaped.Regenerate();
+
+    FMatch3Board Loaded;
+    Loaded.Init(9, 9, 1);
+    Loaded.SetShape(Shape);
+    bool bLocked = false;
+    TestTrue(TEXT("shaped record reads"), FMatch3Snapshot::Read(WriteRecord(Shaped, false), Loaded, bLocked));
+    TestTrue(TEXT("shaped cells"), Loaded.Cells == Shaped.Cells);
+    return true;
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMatch3SnapshotBadRecordTest, "SatJam.Match3.Snapshot.BadRecord",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FMatch3SnapshotBadRecordTest::RunTest(const FString& Parameters)
+{
+    // five colors are packed at 3 bits, so 5, 6 and 7 fit the bits but are not colors
+    FMatch3Board Board;
+    MakePlayedBoard(Board, 10, 6, 5, 1);
+    const TArray<uint8> Good = WriteRecord(Board, false);
+
+    FMatch3Board Target;
+    MakePlayedBoard(Target, 8, 8, 4, 2);
+    const TArray<uint8> TargetCells = Target.Cells;
+
+    auto ReadWith = [this, &Good, &Target, &TargetCells](const TCHAR* What, TFunctionRef<void(TArray<uint8>&)> Patch)
+    {
+        TArray<uint8> Record = Good;
+        Patch(Record);
+        bool bLocked = false;
+        TestFalse(What, FMatch3Snapshot::Read(Record, Target, bLocked));
+        TestTrue(FString::Printf(TEXT("%s: board untouched"), What), Target.Cells == TargetCells && Target.Rows == 8);
+    };
+
+    FMatch3SnapshotHeader Header;
+    FMemory::Memcpy(&Header, Good.GetData(), sizeof(Header));
+    auto WriteHeader = [](TArray<uint8>& Record, const FMatch3SnapshotHeader& NewHeader)
+    {
+        FMemory::Memcpy(Record.GetData(), &NewHeader, sizeof(NewHeader));
+    };
+
+    ReadWith(TEXT("bad magic"), [&](TArray<uint8>& Record) { FMatch3SnapshotHeader H = Header; H.Magic = 0; WriteHeader(Record, H); });
+    ReadWith(TEXT("newer version"), [&](TArray<uint8>& Record) { FMatch3SnapshotHeader H = Header; H.Version = FMatch3Snapshot::CurrentVersion + 1; WriteHeader(Record, H); });
+    ReadWith(TEXT("zero rows"), [&](TArray<uint8>& Record) { FMatch3SnapshotHeader H = Header; H.Rows = 0; WriteHeader(Record, H); });
+    ReadWith(TEXT("too many colors"), [&](TArray<uint8>& Record) { FMatch3SnapshotHeader H = Header; H.NumColors = FMatch3Board::MaxColors + 1; WriteHeader(Record, H); });
+    ReadWith(TEXT("a byte per cell"), [&](TArray<uint8>& Record) { FMatch3SnapshotHeader H = Header; H.BitsPerCell = 8; WriteHeader(Record, H); });
+    ReadWith(TEXT("narrower cells"), [&](TArray<uint8>& Record) { FMatch3SnapshotHeader H = Header; H.BitsPerCell = 2; WriteHeader(Record, H); });
+    ReadWith(TEXT("truncated"), [&](TArray<uint8>& Record) { Record.SetNum(Record.Num() - 4); });
+
+    // a color past the count in the first and the last cell
+    ReadWith(TEXT("color out of range"), [&](TArray<uint8>& Record) { Record[sizeof(Header)] |= 0x07; });
+    ReadWith(TEXT("last color out of range"), [&](TArray<uint8>& Record)
+    {
+        const int32 LastBit = (Board.Num() - 1) * 3;
+        Record[sizeof(Header) + LastBit / 8] |= static_cast<uint8>(0x07 << (LastBit % 8));
+        if (LastBit % 8 > 5)
+        {
+            Record[sizeof(Header) + LastBit / 8 + 1] |= static_cast<uint8>(0x07 >> (8 - LastBit % 8));
+        }
+    });
+
+    bool bLocked = false;
+    TestTrue(TEXT("unchanged record reads"), FMatch3Snapshot::Read(Good, Target, bLocked));
+    return true;
+}
+
+#endif
@@ -0,0 +1,289 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Match3Solver.h"
+#include "Async/ParallelFor.h"
+#include "HAL/IConsoleManager.h"
+
+namespace
+{
+    // lockless table: each entry stores Key ^ Data next to Data, a torn write
+    // fails the key check and reads as a miss
+    class FSolverTable
+    {
+    public:
+        struct FEntry
+        {
+            int32 Value = 0;
+            int32 Remaining = 0;
+            int32 BestMove = INDEX_NONE;
+
+            // Value is the best gain with Remaining moves; otherwise only a lower bound
+            bool bExact = false;
+        };
+
+        explicit FSolverTable(int32 SizeLog2)
+            : Mask((uint64(1) << SizeLog2) - 1)
+        {
+            Slots.SetNumZeroed(static_cast<int64>(Mask + 1) * 2);
+        }
+
+        bool Probe(uint64 Key, FEntry& Out) const
+        {
+            const int64 Slot = static_cast<int64>(Key & Mask) * 2;
+            const uint64 Check = static_cast<uint64>(FPlatformAtomics::AtomicRead_Relaxed(&Slots[Slot]));
+            const uint64 Data = static_cast<uint64>(FPlatformAtomics::AtomicRead_Relaxed(&Slots[Slot + 1]));
+            if (Data == 0 || (Check ^ Data) != Key) return false;
+
+            Out.Value = static_cast<int32>(Data & 0xFFFFFFFFu);
+            Out.Remaining = static_cast<int32>((Data >> 32) & 0xFF);
+            const uint32 Move = static_cast<uint32>((Data >> 40) & 0xFFFF);
+            Out.BestMove = Move == 0xFFFF ? INDEX_NONE : static_cast<int32>(Move);
+            Out.bExact = ((Data >> 56) & 1) != 0;
+            return true;
+        }
+
+        // always replace, the newest result is the most useful for ordering
+        void Store(uint64 Key, int32 Value, int32 Remaining, int32 BestMove, bool bExact)
+        {
+            const uint64 Move = BestMove == INDEX_NONE ? 0xFFFF : static_cast<uint64>(BestMove & 0xFFFF);
+            const uint64 Data = static_cast<uint64>(static_cast<uint32>(Value))
+                | (static_cast<uint64>(Remaining & 0xFF) << 32)
+                | (Move << 40)
+                | (static_cast<uint64>(bExact ? 1 : 0) << 56)
+                | (uint64(1) << 57); // never zero
+
+            const int64 Slot = static_cast<int64>(Key & Mask) * 2;
+            FPlatformAtomics::AtomicStore_Relaxed(&Slots[Slot], static_cast<int64>(Key ^ Data));
+            FPlatformAtomics::AtomicStore_Relaxed(&Slots[Slot + 1], static_cast<int64>(Data));
+        }
+
+    private:
+        const uint64 Mask;
+        TArray<int64> Slots;
+    };
+
+    // one search thread: a board and a move list per ply, no allocation while searching
+    class FSolverSearch
+    {
+    public:
+        FSolverSearch(const FMatch3Board& Start, int32 MaxPly, FSolverTable& InTable)
+            : Table(InTable)
+        {
+            Boards.Init(Start, MaxPly + 1);
+            MoveLists.SetNum(MaxPly + 1);
+            for (FMatch3MoveList& Moves : MoveLists)
+            {
+                Moves.Reserve(Start.Num());
+            }
+        }
+
+        FMatch3Board& GetBoard(int32 Ply) { return Boards[Ply]; }
+
+        // Boards[Ply + 1] = Boards[Ply] after the swap and its turn, returns the points
+        int32 Play(int32 Ply, int32 CellA, int32 CellB)
+        {
+            const FMatch3Board& Parent = Boards[Ply];
+            FMatch3Board& Child = Boards[Ply + 1];
+            Child.CopyCellsFrom(Parent);
+            Child.Score = Parent.Score;
+            Child.Stream = Parent.Stream;
+
+            if (!Child.TrySwap(CellA, CellB)) return 0;
+            Child.ResolveTurn();
+            return Child.Score - Parent.Score;
+        }
+
+        // most points Boards[Ply] can still score in Remaining moves; stops at the
+        // first line worth Needed or more and then only returns a lower bound
+        int32 Gain(int32 Ply, int32 Remaining, int32 Needed)
+        {
+            if (Remaining == 0 || Needed <= 0) return 0;
+            ++Nodes;
+
+            FMatch3Board& Board = Boards[Ply];
+            const uint64 Key = StateKey(Board);
+
+            int32 Hint = INDEX_NONE;
+            FSolverTable::FEntry Entry;
+            if (Table.Probe(Key, Entry))
+            {
+                if (Entry.bExact && Entry.Remaining == Remaining) return Entry.Value;
+
+                // fewer moves reaching it means more moves do too
+                if (Entry.Remaining <= Remaining && Entry.Value >= Needed) return Entry.Value;
+                Hint = Entry.BestMove;
+            }
+
+            FMatch3MoveList& Moves = MoveLists[Ply];
+            Board.FindAllMoves(Moves);
+            const int32 NumMoves = Moves.Moves.Num();
+            if (Hint >= NumMoves)
+            {
+                Hint = INDEX_NONE;
+            }
+
+            int32 Best = 0;
+            int32 BestMove = INDEX_NONE;
+            // the table's best move first, then the rest in order
+            for (int32 i = Hint == INDEX_NONE ? 0 : -1; i < NumMoves; ++i)
+            {
+                if (i == Hint) continue;
+                const int32 MoveIndex = i < 0 ? Hint : i;
+                const FMatch3Move& Move = Moves.Moves[MoveIndex];
+
+                const int32 Points = Play(Ply, Move.CellA, Move.CellB);
+                const int32 Value = Points + Gain(Ply + 1, Remaining - 1, Needed - Points);
+                if (Value > Best || BestMove == INDEX_NONE)
+                {
+                    Best = Value;
+                    BestMove = MoveIndex;
+                }
+                if (Best >= Needed)
+                {
+                    Table.Store(Key, Best, Remaining, BestMove, false);
+                    return Best;
+                }
+            }
+
+            // every child was searched to the end, so this is the exact best
+            Table.Store(Key, Best, Remaining, BestMove, true);
+            return Best;
+        }
+
+        int64 Nodes = 0;
+
+    private:
+        FSolverTable& Table;
+        TArray<FMatch3Board> Boards;
+        TArray<FMatch3MoveList> MoveLists;
+
+        // colors (the board's running hash) plus the stream that makes the refills
+        static uint64 StateKey(const FMatch3Board& Board)
+        {
+            return Board.Hash ^ (static_cast<uint64>(static_cast<uint32>(Board.Stream.GetCurrentSeed())) * 0x9E3779B97F4A7C15ull);
+        }
+    };
+}
+
+FMatch3PuzzleSolution FMatch3PuzzleSolver::Solve(const FMatch3Board& Start, const FMatch3PuzzleSettings& Settings)
+{
+    FMatch3PuzzleSolution Solution;
+    const double StartTime = FPlatformTime::Seconds();
+    const int32 MaxMoves = FMath::Clamp(Settings.MaxMoves, 1, 255);
+    const int32 Target = Settings.TargetPoints > 0 ? Settings.TargetPoints : MAX_int32;
+
+    FSolverTable Table(FMath::Clamp(Settings.TableSizeLog2, 10, 28));
+
+    FMatch3MoveList RootMoves;
+    RootMoves.Reserve(Start.Num());
+    Start.FindAllMoves(RootMoves);
+    const int32 NumRootMoves = RootMoves.Moves.Num();
+    if (NumRootMoves == 0) return Solution;
+
+    TArray<int32> RootValues;
+    RootValues.SetNumZeroed(NumRootMoves);
+    TAtomic<int64> Nodes { 0 };
+
+    // deepen one move at a time, the first depth that reaches the target is the shortest
+    int32 Depth = 0;
+    int32 BestRoot = INDEX_NONE;
+    for (Depth = 1; Depth <= MaxMoves; ++Depth)
+    {
+        ParallelFor(NumRootMoves, [&](int32 Index)
+        {
+            FSolverSearch Search(Start, Depth, Table);
+            const FMatch3Move& Move = RootMoves.Moves[Index];
+            const int32 Points = Search.Play(0, Move.CellA, Move.CellB);
+            RootValues[Index] = Points + Search.Gain(1, Depth - 1, Target - Points);
+            Nodes += Search.Nodes + 1;
+        });
+
+        BestRoot = 0;
+        for (int32 i = 1; i < NumRootMoves; ++i)
+        {
+            if (RootValues[i] > RootValues[BestRoot])
+            {
+                BestRoot = i;
+            }
+        }
+        if (RootValues[BestRoot] >= Target) break;
+    }
+    Depth = FMath::Min(Depth, MaxMoves);
+
+    // walk the line back out of the table; each step takes a move that still
+    // reaches the value the previous step promised
+    // without a solution the root values are exact, so the best line is walked instead
+    FSolverSearch Search(Start, Depth, Table);
+    int32 Promised = RootValues[BestRoot];
+    const bool bTargetMode = Promised >= Target;
+    int32 Needed = bTargetMode ? Target : MAX_int32;
+
+    const FMatch3Move& First = RootMoves.Moves[BestRoot];
+    int32 Points = Search.Play(0, First.CellA, First.CellB);
+    Solution.Line.Add(FIntPoint(First.CellA, First.CellB));
+    Promised -= Points;
+    Needed = bTargetMode ? Needed - Points : MAX_int32;
+
+    FMatch3MoveList Moves;
+    Moves.Reserve(Start.Num());
+    for (int32 Ply = 1; Ply < Depth && Promised > 0 && (!bTargetMode || Needed > 0); ++Ply)
+    {
+        Search.GetBoard(Ply).FindAllMoves(Moves);
+        int32 Chosen = INDEX_NONE;
+        for (int32 i = 0; i < Moves.Moves.Num() && Chosen == INDEX_NONE; ++i)
+        {
+            const int32 MovePoints = Search.Play(Ply, Moves.Moves[i].CellA, Moves.Moves[i].CellB);
+            const int32 Rest = Search.Gain(Ply + 1, Depth - Ply - 1, bTargetMode ? Needed - MovePoints : MAX_int32);
+            if (bTargetMode ? MovePoints + Rest >= Needed : MovePoints + Rest >= Promised)
+            {
+                Chosen = i;
+                Points = MovePoints;
+            }
+        }
+        if (Chosen == INDEX_NONE) break;
+
+        // replay it, the check above left a sibling's board in the next ply
+        Search.Play(Ply, Moves.Moves[Chosen].CellA, Moves.Moves[Chosen].CellB);
+        Solution.Line.Add(FIntPoint(Moves.Moves[Chosen].CellA, Moves.Moves[Chosen].CellB));
+        Promised -= Points;
+        Needed = bTargetMode ? Needed - Points : MAX_int32;
+    }
+
+    Solution.Points = Search.GetBoard(Solution.Line.Num()).Score - Start.Score;
+    Solution.bSolved = Settings.TargetPoints > 0 ? Solution.Points >= Target : Solution.Line.Num() > 0;
+    Solution.Nodes = Nodes + Search.Nodes;
+    Solution.Seconds = FPlatformTime::Seconds() - StartTime;
+    return Solution;
+}
+
+
+static void RunSolvePuzzle(const TArray<FString>& Args)
+{
+    FMatch3PuzzleSettings Settings;
+    Settings.MaxMoves = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 5;
+    Settings.TargetPoints = Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 0;
+    const int32 Seed = Args.Num() > 2 ? FCString::Atoi(*Args[2]) : 1;
+    const int32 Rows = Args.Num() > 3 ? FCString::Atoi(*Args[3]) : 10;
+    const int32 Cols = Args.Num() > 4 ? FCString::Atoi(*Args[4]) : 6;
+    const int32 NumColors = Args.Num() > 5 ? FCString::Atoi(*Args[5]) : FMatch3Board::DefaultNumColors;
+
+    FMatch3Board Board;
+    Board.Init(Rows, Cols, Seed);
+    Board.SetNumColors(NumColors);
+    Board.Regenerate();
+
+    const FMatch3PuzzleSolution Solution = FMatch3PuzzleSolver::Solve(Board, Settings);
+    UE_LOG(LogTemp, Log, TEXT("Match3 puzzle %dx%d, %d colors, seed %d: %s, %d points in %d moves (%lld nodes, %.2f s)"),
+        Rows, Cols, Board.NumColors, Seed, Solution.bSolved ? TEXT("solved") : TEXT("no solution"),
+        Solution.Points, Solution.Line.Num(), Solution.Nodes, Solution.Seconds);
+    for (const FIntPoint& Swap : Solution.Line)
+    {
+        UE_LOG(LogTemp, Log, TEXT("  swap %d-%d"), Swap.X, Swap.Y);
+    }
+}
+
+static FAutoConsoleCommand SolvePuzzleCommand(
+    TEXT("Match3.SolvePuzzle"),
+    TEXT("Solve a generated board as a puzzle: Match3.SolvePuzzle [Moves=5] [TargetPoints=0 for best] [Seed=1] [Rows=10] [Cols=6] [Colors=4]"),
+    FConsoleCommandWithArgsDelegate::CreateStatic(&RunSolvePuzzle));
@@ -0,0 +1,45 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Match3Board.h"
+
+struct FMatch3PuzzleSettings
+{
+    // most swaps the player gets
+    int32 MaxMoves = 5;
+
+    // points to reach; 0 finds the best line in MaxMoves instead
+    int32 TargetPoints = 0;
+
+    // transposition table entries, as a power of two (16 bytes each)
+    int32 TableSizeLog2 = 22;
+};
+
+struct FMatch3PuzzleSolution
+{
+    // the target is reachable (best line mode: the board has a move)
+    bool bSolved = false;
+
+    // points the line scores
+    int32 Points = 0;
+
+    // swaps in order, X = CellA, Y = CellB; the shortest line that reaches the
+    // target, or the best scoring one in MaxMoves
+    TArray<FIntPoint> Line;
+
+    int64 Nodes = 0;
+    double Seconds = 0.0;
+};
+
+// exhaustive solver for puzzle levels ("reach N points in K moves")
+// refills come from the board's own stream, so a board plus its stream state
+// fixes every outcome; iterative deepening on the move count finds the shortest
+// line, a transposition table shared by all threads keeps boards reached in
+// several ways (or at an earlier depth) from being searched again, and the root
+// moves of each depth are searched in parallel
+struct SATJAM_MATCH3_API FMatch3PuzzleSolver
+{
+    static FMatch3PuzzleSolution Solve(const FMatch3Board& Start, const FMatch3PuzzleSettings& Settings);
+};
@@ -0,0 +1,105 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Match3Solver.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    // every line on board copies, no table and no cutoffs: the most points Board
+    // scores in Remaining moves
+    int32 BruteForceBest(const FMatch3Board& Board, int32 Remaining)
+    {
+        if (Remaining == 0) return 0;
+
+        FMatch3MoveList Moves;
+        Board.FindAllMoves(Moves);
+        int32 Best = 0;
+        for (const FMatch3Move& Move : Moves.Moves)
+        {
+            FMatch3Board Child;
+            Child.CopyFrom(Board);
+            if (!Child.TrySwap(Move.CellA, Move.CellB)) continue;
+            Child.ResolveTurn();
+            Best = FMath::Max(Best, Child.Score - Board.Score + BruteForceBest(Child, Remaining - 1));
+        }
+        return Best;
+    }
+
+    // the line played on a copy of Start, false if a swap is refused
+    bool ReplayLine(const FMatch3Board& Start, const TArray<FIntPoint>& Line, int32& OutPoints)
+    {
+        FMatch3Board Board;
+        Board.CopyFrom(Start);
+        for (const FIntPoint& Swap : Line)
+        {
+            if (!Board.TrySwap(Swap.X, Swap.Y)) return false;
+            Board.ResolveTurn();
+        }
+        OutPoints = Board.Score - Start.Score;
+        return true;
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMatch3SolverBruteForceTest, "SatJam.Match3.Solver.MatchesBruteForce",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FMatch3SolverBruteForceTest::RunTest(const FString& Parameters)
+{
+    // a kernel size and a generic one, small enough to try every line
+    const FIntPoint Sizes[] = { { 6, 6 }, { 5, 7 } };
+    constexpr int32 MaxMoves = 3;
+
+    for (const FIntPoint& Size : Sizes)
+    {
+        for (int32 Seed = 1; Seed <= 4; ++Seed)
+        {
+            FMatch3Board Start;
+            Start.Init(Size.X, Size.Y, Seed);
+            Start.SetNumColors(4 + Seed % 2);
+            Start.Regenerate();
+
+            int32 BestByDepth[MaxMoves + 1];
+            for (int32 Depth = 0; Depth <= MaxMoves; ++Depth)
+            {
+                BestByDepth[Depth] = BruteForceBest(Start, Depth);
+            }
+            const int32 Best = BestByDepth[MaxMoves];
+
+            FMatch3PuzzleSettings Settings;
+            Settings.MaxMoves = MaxMoves;
+            Settings.TableSizeLog2 = 16;
+
+            // best line mode
+            const FMatch3PuzzleSolution BestLine = FMatch3PuzzleSolver::Solve(Start, Settings);
+            TestTrue(TEXT("best line solved"), BestLine.bSolved);
+            TestEqual(TEXT("best line points"), BestLine.Points, Best);
+            int32 Replayed = 0;
+            TestTrue(TEXT("best line replays"), ReplayLine(Start, BestLine.Line, Replayed));
+            TestEqual(TEXT("best line replayed points"), Replayed, BestLine.Points);
+
+            // target mode: the brute force best is reached in the fewest moves that can
+            int32 Shortest = 1;
+            while (BestByDepth[Shortest] < Best)
+            {
+                ++Shortest;
+            }
+            Settings.TargetPoints = Best;
+            const FMatch3PuzzleSolution Target = FMatch3PuzzleSolver::Solve(Start, Settings);
+            TestTrue(TEXT("target solved"), Target.bSolved);
+            TestTrue(TEXT("target reached"), Target.Points >= Best);
+            TestEqual(TEXT("target in the fewest moves"), Target.Line.Num(), Shortest);
+            TestTrue(TEXT("target line replays"), ReplayLine(Start, Target.Line, Replayed));
+            TestEqual(TEXT("target line replayed points"), Replayed, Target.Points);
+
+            // and one point more is out of reach
+            Settings.TargetPoints = Best + 1;
+            TestFalse(TEXT("unreachable target"), FMatch3PuzzleSolver::Solve(Start, Settings).bSolved);
+        }
+    }
+    return true;
+}
+
+#endif
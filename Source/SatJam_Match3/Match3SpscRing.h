@@ -0,0 +1,77 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// fixed size single producer / single consumer ring, no locks or allocation
+// one thread pushes, one other thread pops; Capacity is a power of two
+template <typename ElementType, uint32 Capacity>
+class TMatch3SpscRing
+{
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    static constexpr uint32 NumSlots = Capacity;
+
+    // producer: false if the ring is full
+    bool Push(const ElementType& Element)
+    {
+        ElementType* Slot = BeginPush();
+        if (!Slot) return false;
+        *Slot = Element;
+        FinishPush();
+        return true;
+    }
+
+    // producer: fill the next slot in place (its buffers are kept), then FinishPush
+    ElementType* BeginPush()
+    {
+        const uint32 H = Head.Load(EMemoryOrder::Relaxed);
+        if (H - Tail.Load() >= Capacity) return nullptr;
+        return &Slots[H & (Capacity - 1)];
+    }
+
+    void FinishPush()
+    {
+        Head.Store(Head.Load(EMemoryOrder::Relaxed) + 1);
+    }
+
+    // consumer: oldest element or null, then Pop when done with it
+    ElementType* Peek()
+    {
+        const uint32 T = Tail.Load(EMemoryOrder::Relaxed);
+        if (T == Head.Load()) return nullptr;
+        return &Slots[T & (Capacity - 1)];
+    }
+
+    void Pop()
+    {
+        Tail.Store(Tail.Load(EMemoryOrder::Relaxed) + 1);
+    }
+
+    // consumer: append everything pushed so far to Out
+    int32 PopAll(TArray<ElementType>& Out)
+    {
+        const uint32 T = Tail.Load(EMemoryOrder::Relaxed);
+        const uint32 H = Head.Load();
+        for (uint32 i = T; i != H; ++i)
+        {
+            Out.Add(Slots[i & (Capacity - 1)]);
+        }
+        Tail.Store(H);
+        return static_cast<int32>(H - T);
+    }
+
+    bool IsEmpty() const
+    {
+        return Tail.Load() == Head.Load();
+    }
+
+private:
+    ElementType Slots[Capacity];
+
+    // free running, only the owning side stores
+    alignas(PLATFORM_CACHE_LINE_SIZE) TAtomic<uint32> Head { 0 };
+    alignas(PLATFORM_CACHE_LINE_SIZE) TAtomic<uint32> Tail { 0 };
+};
@@ -0,0 +1,180 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Match3Telemetry.h"
+#include "HAL/Event.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/RunnableThread.h"
+#include "Serialization/MemoryReader.h"
+
+// how often the writer wakes up to empty the ring, well before it can fill
+static constexpr uint32 DrainIntervalMs = 20;
+
+const TCHAR* FMatch3TelemetryFile::GetEventName(EMatch3TelemetryEvent Type)
+{
+    switch (Type)
+    {
+    case EMatch3TelemetryEvent::SwapAccepted: return TEXT("SwapAccepted");
+    case EMatch3TelemetryEvent::SwapRejected: return TEXT("SwapRejected");
+    case EMatch3TelemetryEvent::CascadeStep: return TEXT("CascadeStep");
+    case EMatch3TelemetryEvent::TurnEnd: return TEXT("TurnEnd");
+    case EMatch3TelemetryEvent::Locked: return TEXT("Locked");
+    case EMatch3TelemetryEvent::Regenerate: return TEXT("Regenerate");
+    case EMatch3TelemetryEvent::Shuffle: return TEXT("Shuffle");
+    case EMatch3TelemetryEvent::ResolveFrame: return TEXT("ResolveFrame");
+    case EMatch3TelemetryEvent::Dropped: return TEXT("Dropped");
+    default: return TEXT("Unknown");
+    }
+}
+
+
+bool FMatch3TelemetryFile::ToCsv(const TArray<uint8>& Data, FString& OutCsv)
+{
+    FMemoryReader Ar(Data);
+
+    uint32 FileMagic = 0;
+    uint16 Version = 0;
+    uint16 Rows = 0;
+    uint16 Cols = 0;
+    int32 Seed = 0;
+    Ar << FileMagic;
+    Ar << Version;
+    if (FileMagic != Magic || Version > CurrentVersion)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("Telemetry: bad header (magic %08x, version %d)"), FileMagic, Version);
+        return false;
+    }
+    Ar << Rows;
+    Ar << Cols;
+    Ar << Seed;
+    if (Ar.IsError()) return false;
+
+    OutCsv = FString::Printf(TEXT("# rows=%d cols=%d seed=%d\nTimeMs,Event,A,B\n"), Rows, Cols, Seed);
+
+    uint64 TimeUs = 0;
+    while (Ar.Tell() < Ar.TotalSize())
+    {
+        uint8 Type = 0;
+        uint32 DeltaUs = 0;
+        uint32 A = 0;
+        uint32 B = 0;
+        Ar << Type;
+        Ar.SerializeIntPacked(DeltaUs);
+        Ar.SerializeIntPacked(A);
+        Ar.SerializeIntPacked(B);
+        if (Ar.IsError())
+        {
+            // the game was killed mid write, keep what was complete
+            UE_LOG(LogTemp, Warning, TEXT("Telemetry: truncated event at byte %lld"), Ar.Tell());
+            break;
+        }
+
+        TimeUs += DeltaUs;
+        OutCsv += FString::Printf(TEXT("%.3f,%s,%d,%d\n"), TimeUs / 1000.0,
+            GetEventName(static_cast<EMatch3TelemetryEvent>(Type)), static_cast<int32>(A), static_cast<int32>(B));
+    }
+    return true;
+}
+
+
+FMatch3TelemetryWriter::FMatch3TelemetryWriter(const FString& Filename, int32 Rows, int32 Cols, int32 Seed)
+{
+    Archive.Reset(IFileManager::Get().CreateFileWriter(*Filename));
+    if (!Archive)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("Telemetry: could not create %s"), *Filename);
+        return;
+    }
+
+    uint32 FileMagic = FMatch3TelemetryFile::Magic;
+    uint16 Version = FMatch3TelemetryFile::CurrentVersion;
+    uint16 Rows16 = static_cast<uint16>(Rows);
+    uint16 Cols16 = static_cast<uint16>(Cols);
+    *Archive << FileMagic;
+    *Archive << Version;
+    *Archive << Rows16;
+    *Archive << Cols16;
+    *Archive << Seed;
+
+    Batch.Reserve(FMatch3TelemetryRing::NumSlots);
+    LastCycles = FPlatformTime::Cycles64();
+
+    WakeEvent = FPlatformProcess::GetSynchEventFromPool(false);
+    Thread = FRunnableThread::Create(this, TEXT("Match3Telemetry"), 0, TPri_Lowest);
+}
+
+
+FMatch3TelemetryWriter::~FMatch3TelemetryWriter()
+{
+    if (Thread)
+    {
+        // Kill calls Stop and waits for Run to return, Run writes the rest
+        Thread->Kill(true);
+        delete Thread;
+        Thread = nullptr;
+    }
+
+    if (WakeEvent)
+    {
+        FPlatformProcess::ReturnSynchEventToPool(WakeEvent);
+        WakeEvent = nullptr;
+    }
+
+    if (Archive)
+    {
+        Archive->Close();
+    }
+}
+
+
+uint32 FMatch3TelemetryWriter::Run()
+{
+    while (!bStopping)
+    {
+        WakeEvent->Wait(DrainIntervalMs);
+        Drain();
+    }
+
+    // events recorded before Stop
+    Drain();
+    Archive->Flush();
+    return 0;
+}
+
+
+void FMatch3TelemetryWriter::Stop()
+{
+    bStopping = true;
+    WakeEvent->Trigger();
+}
+
+
+void FMatch3TelemetryWriter::Drain()
+{
+    Batch.Reset();
+    Ring.PopAll(Batch);
+
+    const int32 Dropped = NumDropped.Exchange(0);
+    if (Dropped > 0)
+    {
+        const uint64 Cycles = Batch.Num() > 0 ? Batch.Last().Cycles : LastCycles;
+        Batch.Add({ Cycles, Dropped, 0, EMatch3TelemetryEvent::Dropped });
+    }
+
+    const double MicrosecondsPerCycle = FPlatformTime::GetSecondsPerCycle64() * 1e6;
+    for (const FMatch3TelemetryEvent& Event : Batch)
+    {
+        // time rounds down per event, carry the remainder in LastCycles
+        uint32 DeltaUs = static_cast<uint32>((Event.Cycles - LastCycles) * MicrosecondsPerCycle);
+        LastCycles += static_cast<uint64>(DeltaUs / MicrosecondsPerCycle);
+
+        uint8 Type = static_cast<uint8>(Event.Type);
+        uint32 A = static_cast<uint32>(Event.A);
+        uint32 B = static_cast<uint32>(Event.B);
+        *Archive << Type;
+        Archive->SerializeIntPacked(DeltaUs);
+        Archive->SerializeIntPacked(A);
+        Archive->SerializeIntPacked(B);
+    }
+}
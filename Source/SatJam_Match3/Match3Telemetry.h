@@ -0,0 +1,91 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include "Match3SpscRing.h"
+
+class FRunnableThread;
+class FEvent;
+
+// what a telemetry event's A and B hold
+enum class EMatch3TelemetryEvent : uint8
+{
+    SwapAccepted,   // A, B = cells
+    SwapRejected,   // A, B = cells
+    CascadeStep,    // A = cells cleared, B = depth
+    TurnEnd,        // A = cells cleared, B = depth
+    Locked,         // A = microseconds input was locked for the turn
+    Regenerate,     // A = regen seed (0 without the pool)
+    Shuffle,
+    ResolveFrame,   // A = microseconds of game thread work for one cascade step
+    Dropped,        // A = events lost to a full ring
+    Count
+};
+
+struct FMatch3TelemetryEvent
+{
+    uint64 Cycles;
+    int32 A;
+    int32 B;
+    EMatch3TelemetryEvent Type;
+};
+
+// the game thread pushes, the writer thread pops; a full ring drops the event
+using FMatch3TelemetryRing = TMatch3SpscRing<FMatch3TelemetryEvent, 8192>;
+
+// one session's telemetry file
+//
+// file layout (little endian, versioned):
+//   uint32 Magic, uint16 Version, uint16 Rows, uint16 Cols, int32 Seed
+//   then until the end: uint8 Type, packed uint32 microseconds since the previous
+//   event, packed uint32 A, packed uint32 B
+struct SATJAM_MATCH3_API FMatch3TelemetryFile
+{
+    static constexpr uint32 Magic = 0x4C54334D; // "M3TL"
+    static constexpr uint16 CurrentVersion = 1;
+
+    static const TCHAR* GetEventName(EMatch3TelemetryEvent Type);
+
+    // one row per event: TimeMs,Event,A,B; false on a bad header
+    static bool ToCsv(const TArray<uint8>& Data, FString& OutCsv);
+};
+
+// streams events to a file on its own thread
+// Record is the only game thread cost: a timestamp and a ring push
+class SATJAM_MATCH3_API FMatch3TelemetryWriter : public FRunnable
+{
+public:
+    FMatch3TelemetryWriter(const FString& Filename, int32 Rows, int32 Cols, int32 Seed);
+    virtual ~FMatch3TelemetryWriter();
+
+    bool IsOpen() const { return Archive.IsValid(); }
+
+    void Record(EMatch3TelemetryEvent Type, int32 A = 0, int32 B = 0)
+    {
+        if (!Ring.Push({ FPlatformTime::Cycles64(), A, B, Type }))
+        {
+            ++NumDropped;
+        }
+    }
+
+    // FRunnable
+    virtual uint32 Run() override;
+    virtual void Stop() override;
+
+private:
+    // writer side: write whatever is in the ring
+    void Drain();
+
+    FMatch3TelemetryRing Ring;
+    TAtomic<int32> NumDropped { 0 };
+
+    TUniquePtr<FArchive> Archive;
+    TArray<FMatch3TelemetryEvent> Batch;
+    uint64 LastCycles = 0;
+
+    FEvent* WakeEvent = nullptr;
+    FRunnableThread* Thread = nullptr;
+    TAtomic<bool> bStopping { false };
+};
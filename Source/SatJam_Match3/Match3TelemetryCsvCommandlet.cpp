@@ -0,0 +1,45 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Match3TelemetryCsvCommandlet.h"
+#include "Match3Telemetry.h"
+#include "Misc/FileHelper.h"
+
+static constexpr auto InputParam = TEXT("input");
+
+UMatch3TelemetryCsvCommandlet::UMatch3TelemetryCsvCommandlet()
+{
+    HelpDescription = TEXT("Converts a Match3 telemetry file to csv.");
+    HelpUsage = TEXT("<Editor-Cmd.exe> <path_to_uproject> -run=Match3TelemetryCsv -input=<session.m3tl> -output=<session.csv> -nullrhi -unattended");
+
+    HelpParamNames.Add(InputParam);
+    HelpParamDescriptions.Add(TEXT("[Required] The telemetry file written by a grid with bRecordTelemetry."));
+}
+
+
+int32 UMatch3TelemetryCsvCommandlet::Run(
+    TArray<FString>& Tokens,
+    TArray<FString>& Switches,
+    TMap<FString, FString>& ParamVals,
+    FArchive& OutArchive)
+{
+    const FString InputFile = ParamVals.FindRef(InputParam);
+    TArray<uint8> Data;
+    if (InputFile.IsEmpty() || !FFileHelper::LoadFileToArray(Data, *InputFile))
+    {
+        UE_LOG(LogTemp, Error, TEXT("Could not read telemetry input: %s."), *InputFile);
+        PrintHelp();
+        return 1;
+    }
+
+    FString Csv;
+    if (!FMatch3TelemetryFile::ToCsv(Data, Csv))
+    {
+        UE_LOG(LogTemp, Error, TEXT("Not a telemetry file: %s."), *InputFile);
+        return 1;
+    }
+
+    FTCHARToUTF8 Utf8(*Csv);
+    OutArchive.Serialize(const_cast<ANSICHAR*>(Utf8.Get()), Utf8.Length());
+    return 0;
+}
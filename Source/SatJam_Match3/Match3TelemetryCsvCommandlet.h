@@ -0,0 +1,24 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Match3CommandletBase.h"
+#include "Match3TelemetryCsvCommandlet.generated.h"
+
+// converts a binary telemetry file (FMatch3TelemetryFile) to csv, offline
+UCLASS()
+class SATJAM_MATCH3_API UMatch3TelemetryCsvCommandlet : public UMatch3CommandletBase
+{
+    GENERATED_BODY()
+
+public:
+    UMatch3TelemetryCsvCommandlet();
+
+protected:
+    virtual int32 Run(
+        TArray<FString>& Tokens,
+        TArray<FString>& Switches,
+        TMap<FString, FString>& ParamVals,
+        FArchive& OutArchive) override;
+};
@@ -0,0 +1,131 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Match3Validator.h"
+#include "Async/ParallelFor.h"
+
+int32 FMatch3SwapValidator::AddBoard(const FMatch3Board& Start)
+{
+    FBoardSlot& Slot = Boards.AddDefaulted_GetRef();
+    Slot.Board.CopyFrom(Start);
+    Slot.SavedCells.Reserve(Start.Num());
+    return Boards.Num() - 1;
+}
+
+
+int32 FMatch3SwapValidator::AddBoard(int32 Rows, int32 Cols, int32 Seed, const FMatch3ScoreRules& Rules, int32 NumColors)
+{
+    FMatch3Board Start;
+    Start.Init(Rows, Cols, Seed);
+    Start.SetNumColors(NumColors);
+    Start.Scoring.Rules = Rules;
+    Start.Regenerate();
+    return AddBoard(Start);
+}
+
+
+void FMatch3SwapValidator::RemoveAllBoards()
+{
+    Boards.Reset();
+}
+
+
+void FMatch3SwapValidator::ValidateBatch(TConstArrayView<FMatch3SwapClaim> Claims, TArray<FMatch3ClaimVerdict>& OutVerdicts)
+{
+    OutVerdicts.SetNum(Claims.Num());
+
+    // group by board, keeping each board's claims in submission order
+    ClaimOrder.SetNumUninitialized(Claims.Num());
+    for (int32 i = 0; i < Claims.Num(); ++i)
+    {
+        ClaimOrder[i] = i;
+    }
+    ClaimOrder.StableSort([&Claims](int32 A, int32 B) { return Claims[A].BoardId < Claims[B].BoardId; });
+
+    RunStarts.Reset();
+    for (int32 i = 0; i < ClaimOrder.Num(); ++i)
+    {
+        if (i == 0 || Claims[ClaimOrder[i]].BoardId != Claims[ClaimOrder[i - 1]].BoardId)
+        {
+            RunStarts.Add(i);
+        }
+    }
+    RunStarts.Add(ClaimOrder.Num());
+
+    // every run owns its board and writes only its own verdicts
+    ParallelFor(RunStarts.Num() - 1, [this, Claims, &OutVerdicts](int32 Run)
+    {
+        ValidateRun(Claims, RunStarts[Run], RunStarts[Run + 1], OutVerdicts);
+    });
+}
+
+
+void FMatch3SwapValidator::ValidateRun(TConstArrayView<FMatch3SwapClaim> Claims, int32 First, int32 Last, TArray<FMatch3ClaimVerdict>& OutVerdicts)
+{
+    const int32 BoardId = Claims[ClaimOrder[First]].BoardId;
+    if (!Boards.IsValidIndex(BoardId))
+    {
+        for (int32 i = First; i < Last; ++i)
+        {
+            OutVerdicts[ClaimOrder[i]] = FMatch3ClaimVerdict();
+        }
+        return;
+    }
+
+    FBoardSlot& Slot = Boards[BoardId];
+    FMatch3Board& Board = Slot.Board;
+
+    for (int32 i = First; i < Last; ++i)
+    {
+        const FMatch3SwapClaim& Claim = Claims[ClaimOrder[i]];
+        FMatch3ClaimVerdict& Verdict = OutVerdicts[ClaimOrder[i]];
+        Verdict = FMatch3ClaimVerdict();
+        Verdict.Score = Board.Score;
+
+        if (!Board.AreAdjacent(Claim.CellA, Claim.CellB))
+        {
+            Verdict.Result = EMatch3ClaimResult::NotAdjacent;
+            continue;
+        }
+
+        // keep what a rejected claim has to restore; refills move the stream
+        Slot.SavedCells = Board.Cells;
+        const FRandomStream SavedStream = Board.Stream;
+        const int32 SavedScore = Board.Score;
+
+        if (!Board.TrySwap(Claim.CellA, Claim.CellB))
+        {
+            Verdict.Result = EMatch3ClaimResult::NoMatch;
+            continue;
+        }
+
+        // ResolveTurn, with the client's pooled board when it used one
+        int32 Depth = 0;
+        if (Board.ResolveCascade(Depth) && !Board.TryShuffleDeadBoard())
+        {
+            if (Claim.bReseeded)
+            {
+                Board.RegenerateFromSeed(Claim.RegenSeed);
+            }
+            else
+            {
+                Board.Regenerate();
+            }
+        }
+        Verdict.CascadeDepth = Depth;
+        Verdict.TurnPoints = Board.Scoring.Turn.Points;
+        Verdict.Score = Board.Score;
+
+        if (Board.Score == Claim.ClaimedScore)
+        {
+            Verdict.Result = EMatch3ClaimResult::Accepted;
+            continue;
+        }
+
+        Verdict.Result = EMatch3ClaimResult::ScoreMismatch;
+        Board.Cells = Slot.SavedCells;
+        Board.CellsChanged();
+        Board.Stream = SavedStream;
+        Board.Score = SavedScore;
+    }
+}
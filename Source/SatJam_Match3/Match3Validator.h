@@ -0,0 +1,79 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Match3Board.h"
+
+// a client's claim that swapping two cells on one of its boards ends the turn at ClaimedScore
+struct FMatch3SwapClaim
+{
+    int32 BoardId = INDEX_NONE;
+    int32 CellA = INDEX_NONE;
+    int32 CellB = INDEX_NONE;
+    int32 ClaimedScore = 0;
+
+    // the turn ended on a dead board the client replaced with a pooled one made from
+    // RegenSeed (FMatch3Board::RegenerateFromSeed); otherwise it regenerated from its stream
+    bool bReseeded = false;
+    int32 RegenSeed = 0;
+};
+
+enum class EMatch3ClaimResult : uint8
+{
+    Accepted,
+    UnknownBoard,
+    NotAdjacent,
+    NoMatch,
+    ScoreMismatch,
+};
+
+// recomputed result; rejected claims leave the board as it was and report its score
+struct FMatch3ClaimVerdict
+{
+    EMatch3ClaimResult Result = EMatch3ClaimResult::UnknownBoard;
+    int32 Score = 0;
+    int32 TurnPoints = 0;
+    int32 CascadeDepth = 0;
+
+    bool IsAccepted() const { return Result == EMatch3ClaimResult::Accepted; }
+};
+
+// authoritative headless boards for server-side validation, no actors involved
+// a batch is split by board: claims on one board run in order on one worker,
+// different boards run in parallel
+class SATJAM_MATCH3_API FMatch3SwapValidator
+{
+public:
+    // add an authoritative copy of the client's starting board (AMatch3Grid::GetBoard after
+    // BeginPlay, or a snapshot), with its rules: shape, colors, cascade cap, shuffles and stream
+    int32 AddBoard(const FMatch3Board& Start);
+
+    // a rectangle regenerated from Seed, shuffles off and the default cascade
+    // cap; grids with other rules add a copy of their board instead
+    int32 AddBoard(int32 Rows, int32 Cols, int32 Seed, const FMatch3ScoreRules& Rules, int32 NumColors = FMatch3Board::DefaultNumColors);
+    void RemoveAllBoards();
+
+    int32 NumBoards() const { return Boards.Num(); }
+    const FMatch3Board& GetBoard(int32 BoardId) const { return Boards[BoardId].Board; }
+
+    // one verdict per claim, same order; accepted claims advance their board
+    void ValidateBatch(TConstArrayView<FMatch3SwapClaim> Claims, TArray<FMatch3ClaimVerdict>& OutVerdicts);
+
+private:
+    struct FBoardSlot
+    {
+        FMatch3Board Board;
+
+        // rollback copy for a rejected claim
+        TArray<uint8> SavedCells;
+    };
+
+    TArray<FBoardSlot> Boards;
+
+    // claim indices grouped by board, and where each board's run starts
+    TArray<int32> ClaimOrder;
+    TArray<int32> RunStarts;
+
+    void ValidateRun(TConstArrayView<FMatch3SwapClaim> Claims, int32 First, int32 Last, TArray<FMatch3ClaimVerdict>& OutVerdicts);
+};
@@ -0,0 +1,101 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Match3Validator.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMatch3ValidatorHonestClaimsTest, "SatJam.Match3.Validator.HonestClaims",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FMatch3ValidatorHonestClaimsTest::RunTest(const FString& Parameters)
+{
+    // small boards with many colors end on dead boards often, so shuffles, the
+    // cascade cap, the shape and pooled reseeds all come up
+    constexpr int32 NumBoards = 4;
+    FMatch3Board Clients[NumBoards];
+    FMatch3SwapValidator Validator;
+    for (int32 i = 0; i < NumBoards; ++i)
+    {
+        FMatch3Board& Client = Clients[i];
+        Client.Init(5, 5, i + 1);
+        Client.SetNumColors(6);
+        Client.bShuffleDeadBoards = (i & 1) != 0;
+        Client.MaxCascadeDepth = i < 2 ? 2 : 100;
+        if (i == 3)
+        {
+            const FIntPoint Holes[] = { { 0, 0 }, { 2, 2 } };
+            Client.SetShape(FMatch3BoardShape::Make(5, 5, Holes, TConstArrayView<FIntPoint>()));
+        }
+        Client.Regenerate();
+        TestEqual(TEXT("board ids in order"), Validator.AddBoard(Client), i);
+    }
+
+    // each client plays legal moves; half of its dead boards come from the pool
+    TArray<FMatch3SwapClaim> Claims;
+    FMatch3MoveList Moves;
+    FRandomStream Picks(47);
+    int32 NumReseeds = 0;
+    for (int32 Turn = 0; Turn < 300; ++Turn)
+    {
+        const int32 BoardId = Turn % NumBoards;
+        FMatch3Board& Client = Clients[BoardId];
+        Client.FindAllMoves(Moves);
+        if (!TestTrue(TEXT("client board has a move"), Moves.Moves.Num() > 0)) break;
+        const FMatch3Move& Move = Moves.Moves[Picks.RandHelper(Moves.Moves.Num())];
+
+        FMatch3SwapClaim& Claim = Claims.AddDefaulted_GetRef();
+        Claim.BoardId = BoardId;
+        Claim.CellA = Move.CellA;
+        Claim.CellB = Move.CellB;
+
+        int32 Depth = 0;
+        Client.TrySwap(Move.CellA, Move.CellB);
+        if (Client.ResolveCascade(Depth) && !Client.TryShuffleDeadBoard())
+        {
+            Claim.bReseeded = Picks.RandBool();
+            if (Claim.bReseeded)
+            {
+                Claim.RegenSeed = static_cast<int32>(Picks.GetUnsignedInt());
+                Client.RegenerateFromSeed(Claim.RegenSeed);
+                NumReseeds++;
+            }
+            else
+            {
+                Client.Regenerate();
+            }
+        }
+        Claim.ClaimedScore = Client.Score;
+    }
+    TestTrue(TEXT("some turns used the pool"), NumReseeds > 0);
+
+    TArray<FMatch3ClaimVerdict> Verdicts;
+    Validator.ValidateBatch(Claims, Verdicts);
+    for (const FMatch3ClaimVerdict& Verdict : Verdicts)
+    {
+        if (!TestTrue(TEXT("honest claim accepted"), Verdict.IsAccepted())) break;
+    }
+    for (int32 i = 0; i < NumBoards; ++i)
+    {
+        TestTrue(TEXT("authoritative board matches the client"), Validator.GetBoard(i).Cells == Clients[i].Cells);
+    }
+
+    // a wrong score is refused and leaves the board alone
+    Clients[0].FindAllMoves(Moves);
+    if (Moves.Moves.Num() > 0)
+    {
+        FMatch3SwapClaim Cheat;
+        Cheat.BoardId = 0;
+        Cheat.CellA = Moves.Moves[0].CellA;
+        Cheat.CellB = Moves.Moves[0].CellB;
+        Cheat.ClaimedScore = Clients[0].Score + 1000000;
+        Validator.ValidateBatch(TConstArrayView<FMatch3SwapClaim>(&Cheat, 1), Verdicts);
+        TestTrue(TEXT("inflated score rejected"), Verdicts[0].Result == EMatch3ClaimResult::ScoreMismatch);
+        TestTrue(TEXT("rejected claim rolled back"), Validator.GetBoard(0).Cells == Clients[0].Cells);
+        TestEqual(TEXT("rejected claim keeps the score"), Validator.GetBoard(0).Score, Clients[0].Score);
+    }
+    return true;
+}
+
+#endif
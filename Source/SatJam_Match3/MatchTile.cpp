@@ -37,24 +37,50 @@ void AMatchTile::SetColor(ETileColor NewColor)
     Color = NewColor;
 
     // set material
-    switch (Color)
+    TileMesh->SetMaterial(0, GetColorMaterial(Color));
+}
+
+
+UMaterialInterface* AMatchTile::GetColorMaterial(ETileColor InColor) const
+{
+    switch (InColor)
     {
     case ETileColor::Red:
-        TileMesh->SetMaterial(0, RedMaterial);
-        break;
+        return RedMaterial;
 
     case ETileColor::Blue:
-        TileMesh->SetMaterial(0, BlueMaterial);
-        break;
+        return BlueMaterial;
 
     case ETileColor::Green:
-        TileMesh->SetMaterial(0, GreenMaterial);
-        break;
+        return GreenMaterial;
 
     case ETileColor::Yellow:
-        TileMesh->SetMaterial(0, YellowMaterial);
-        break;
+        return YellowMaterial;
+
+    case ETileColor::Purple:
+        return PurpleMaterial;
+
+    case ETileColor::Orange:
+        return OrangeMaterial;
+
+    case ETileColor::Cyan:
+        return CyanMaterial;
+
+    case ETileColor::Pink:
+        return PinkMaterial;
+    }
+    return nullptr;
+}
+
+
+int32 AMatchTile::GetNumColorMaterials() const
+{
+    int32 Count = 0;
+    while (Count <= static_cast<int32>(ETileColor::Pink) && GetColorMaterial(static_cast<ETileColor>(Count)))
+    {
+        ++Count;
     }
+    return Count;
 }
 
 
@@ -6,13 +6,19 @@
 #include "GameFramework/Actor.h"
 #include "MatchTile.generated.h"
 
+// board colors in order, a grid with NumColors colors uses the first NumColors
+// (FMatch3Board::MaxColors values)
 UENUM(BlueprintType)
 enum class ETileColor : uint8
 {
     Red,
     Blue,
     Green,
-    Yellow
+    Yellow,
+    Purple,
+    Orange,
+    Cyan,
+    Pink
 };
 
 UCLASS()
@@ -49,12 +55,30 @@ public:
     UPROPERTY(EditAnywhere, Category = "Tile")
     UMaterialInterface* YellowMaterial;
 
+    UPROPERTY(EditAnywhere, Category = "Tile")
+    UMaterialInterface* PurpleMaterial;
+
+    UPROPERTY(EditAnywhere, Category = "Tile")
+    UMaterialInterface* OrangeMaterial;
+
+    UPROPERTY(EditAnywhere, Category = "Tile")
+    UMaterialInterface* CyanMaterial;
+
+    UPROPERTY(EditAnywhere, Category = "Tile")
+    UMaterialInterface* PinkMaterial;
+
     // det the tile's logical grid position and move it to world location
     void SetGridPosition(int32 NewRow, int32 NewCol, const FVector& CellSize, const FVector& GridOrigin);
 
     // change color and update visual
     void SetColor(ETileColor NewColor);
 
+    // the material set for a color, null if the Blueprint leaves it empty
+    UMaterialInterface* GetColorMaterial(ETileColor InColor) const;
+
+    // colors with a material, counted from Red up to the first one without
+    int32 GetNumColorMaterials() const;
+
     // returns world location for given row/col
     static FVector GetWorldLocationForGrid(int32 InRow, int32 InCol, const FVector& CellSize, const FVector& GridOrigin);
 };